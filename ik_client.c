@@ -0,0 +1,74 @@
+/* example client of ik_server and latency benchmark of the shared memory
+ * ring. sends `requests` targets along a circle one at a time and reports
+ * the round trip latencies, then again keeping the ring full and reports
+ * the throughput.
+ *
+ *     ik_client [name] [requests] [stop]
+ *
+ * with `stop` the server is stopped afterwards. */
+
+#define IK_NO_MAIN
+#include "skeleton.c"
+
+static int __client_cmp(const void* _a, const void* _b) {
+	uint64_t a = *(const uint64_t*) _a, b = *(const uint64_t*) _b;
+	return (a > b) - (a < b);
+}
+
+static vec3f __client_target(int _i) {
+	return (vec3f) {200 * cos(_i * 0.01), 200 * sin(_i * 0.01), 50 * sin(_i * 0.003)};
+}
+
+int main(int argc, char** argv) {
+	const char* name = argc > 1 ? argv[1] : IK_SHM_NAME;
+	int requests = argc > 2 ? atoi(argv[2]) : 10000;
+	
+	if (requests < 1) {
+		fprintf(stderr, "usage: ik_client [name] [requests] [stop] (at least 1 request)\n");
+		return 1;
+	}
+	
+	struct ik_shm shm;
+	if (ik_shm_open(&shm, name) == -1) XERR("failed to open the shared memory segment!", ERROR_FAILED_ALLOCATE);
+	
+	uint64_t* ns = malloc(requests * sizeof(uint64_t));
+	struct ik_node_pose* poses = malloc(shm.header->num_nodes * sizeof(struct ik_node_pose));
+	struct ik_solve_result res;
+	real error = 0;
+	if (!ns || !poses) XERR("failed to allocate memory!", ERROR_FAILED_ALLOCATE);
+	
+	// one request in flight
+	for (int i = 0; i < requests; i++) {
+		uint64_t start = __tp_now_ns();
+		if (ik_shm_solve(&shm, __client_target(i), poses, &res) == -1) XERR("the server stopped!", ERROR_FAILED_ALLOCATE);
+		ns[i] = __tp_now_ns() - start;
+		if (res.error > error) error = res.error;
+	}
+	
+	qsort(ns, requests, sizeof(uint64_t), __client_cmp);
+	printf(
+		"round trip: min %llu ns, p50 %llu ns, p99 %llu ns, max %llu ns (worst error %g)\n",
+		(unsigned long long) ns[0], (unsigned long long) ns[requests / 2],
+		(unsigned long long) ns[requests * 99 / 100], (unsigned long long) ns[requests - 1], (double) error
+	);
+	
+	// the ring kept full
+	uint64_t start = __tp_now_ns();
+	for (int sent = 0, received = 0; received < requests;) {
+		while (sent < requests && ik_shm_submit(&shm, __client_target(sent)) == 0) sent++;
+		
+		if (!ik_shm_result(&shm)) XERR("the server stopped!", ERROR_FAILED_ALLOCATE);
+		ik_shm_release(&shm);
+		received++;
+	}
+	
+	double s = (__tp_now_ns() - start) * 1e-9;
+	printf("pipelined: %d requests in %.3f s, %.0f per second\n", requests, s, requests / s);
+	
+	if (argc > 3 && !strcmp(argv[3], "stop")) ik_shm_stop(&shm);
+	
+	free(ns);
+	free(poses);
+	ik_shm_close(&shm);
+	return 0;
+}
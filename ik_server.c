@@ -0,0 +1,48 @@
+/* standalone IK server, solves targets sent by clients through the shared
+ * memory ring of inc/ik_shm.h.
+ *
+ *     ik_server [name] [bones] [length]
+ *
+ * runs until SIGINT or SIGTERM (or `ik_shm_stop` from a client). */
+
+#define IK_NO_MAIN
+#include "skeleton.c"
+
+#include <signal.h>
+
+#define IK_SERVER_CAPACITY 64
+
+struct ik_shm __server_shm;
+
+void __server_stop(int _sig) {
+	ik_shm_stop(&__server_shm);
+}
+
+int main(int argc, char** argv) {
+	const char* name = argc > 1 ? argv[1] : IK_SHM_NAME;
+	int bones = argc > 2 ? atoi(argv[2]) : 100;
+	real length = argc > 3 ? atof(argv[3]) : 5;
+	
+	if (bones < 1) {
+		fprintf(stderr, "usage: ik_server [name] [bones] [length] (at least 1 bone)\n");
+		return 1;
+	}
+	
+	struct arena scene;
+	struct ik_chain chain;
+	if (arena_init(&scene, IK_CHAIN_ARENA_SIZE(bones)) == -1) XERR("failed to allocate memory!", ERROR_FAILED_ALLOCATE);
+	if (ik_make_chain_arena(&chain, &scene, bones, length) == -1) XERR("scene arena is full!", ERROR_FAILED_ALLOCATE);
+	
+	if (ik_shm_create(&__server_shm, name, chain.num_nodes, IK_SERVER_CAPACITY) == -1)
+		XERR("failed to create the shared memory segment!", ERROR_FAILED_ALLOCATE);
+	
+	signal(SIGINT, __server_stop);
+	signal(SIGTERM, __server_stop);
+	
+	printf("serving %s: %d bones of length %g (%d nodes per pose)\n", name, bones, (double) length, chain.num_nodes);
+	printf("solved %llu requests\n", (unsigned long long) ik_shm_serve(&__server_shm, &chain, 0));
+	
+	ik_shm_close(&__server_shm);
+	shm_unlink(name);
+	return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef __CRD_ARENA_H__
+#define __CRD_ARENA_H__
+
+#include <stddef.h>
+#include <stdlib.h>
+
+/* bump allocator over one fixed block. allocations are carved off the front
+ * of the block and are never freed one by one, the whole arena is emptied at
+ * once with `arena_reset` (e.g. when a scene is unloaded). */
+
+#define ARENA_ALIGN 64
+
+struct arena {
+	char* base;
+	size_t size; // bytes in the block
+	size_t used; // bytes handed out so far (including padding)
+};
+
+/* allocates the block of an arena of `_size` bytes. (returns -1 on error) */
+int arena_init(struct arena* _arena, size_t _size) {
+	_size = (_size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+	_arena->base = aligned_alloc(ARENA_ALIGN, _size ? _size : ARENA_ALIGN);
+	_arena->size = _arena->base ? _size : 0;
+	_arena->used = 0;
+	return _arena->base ? 0 : -1;
+}
+
+void arena_free(struct arena* _arena) {
+	free(_arena->base);
+	_arena->base = 0;
+	_arena->size = _arena->used = 0;
+}
+
+/* returns `_size` bytes aligned to `ARENA_ALIGN` (so that allocations never
+ * share a cache line). (returns null if the arena is full) */
+void* arena_alloc(struct arena* _arena, size_t _size) {
+	size_t start = (_arena->used + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+	if (start > _arena->size || _size > _arena->size - start) return 0;
+	
+	_arena->used = start + _size;
+	return _arena->base + start;
+}
+
+/* forgets every allocation, the block is kept for reuse */
+void arena_reset(struct arena* _arena) {
+	_arena->used = 0;
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef __CRD_FIXED_H__
+#define __CRD_FIXED_H__
+
+#include <math.h>
+#include <stdint.h>
+#include "linalg.h"
+
+/* Q16.16 fixed point vectors and quaternions for targets without a (fast)
+ * FPU. values range over +-32768 with a resolution of 1/65536, products are
+ * taken in 64 bits and squared lengths are kept in Q32.32, so neither
+ * overflows. the reciprocal square root and acos come from lookup
+ * tables refined with integer arithmetic, the tables are built once by
+ * `fx_init` (the only floating point code here, besides the conversions). */
+
+typedef int32_t fix16;
+
+#define FX_ONE 65536
+#define FX_PI 205887 // round(pi * 65536)
+#define FX_RSQRT_BITS 10 // bits of the mantissa indexing the rsqrt table
+#define FX_ACOS_SIZE 256 // intervals of the acos table
+
+typedef struct { fix16 x, y, z; } vec3x;
+typedef struct { fix16 r, i, j, k; } qtrnx;
+
+int32_t __fx_rsqrt_lut[1 << FX_RSQRT_BITS]; // rsqrt of the mantissa, Q1.30
+fix16 __fx_acos_lut[FX_ACOS_SIZE + 1]; // acos(1 - s^2) for s in [0, 1]
+int __fx_ready = 0;
+
+/* builds the lookup tables (call once before using any of the functions
+ * below, it is cheap to call again) */
+void fx_init(void) {
+	if (__fx_ready) return;
+	
+	// mantissas m in [2^30, 2^32) are indexed by their top bits, each entry
+	// is the rsqrt of the middle of its interval
+	for (int i = 1 << (FX_RSQRT_BITS - 2); i < 1 << FX_RSQRT_BITS; i++) {
+		double m = (i + 0.5) / (1 << (FX_RSQRT_BITS - 2));
+		__fx_rsqrt_lut[i] = (int32_t) (1073741824.0 / sqrt(m) + 0.5);
+	}
+	
+	// acos has a square root singularity at 1, as a function of
+	// s = sqrt(1 - x) it is smooth enough to interpolate linearly
+	for (int i = 0; i <= FX_ACOS_SIZE; i++) {
+		double s = (double) i / FX_ACOS_SIZE;
+		__fx_acos_lut[i] = (fix16) (acos(1 - s * s) * FX_ONE + 0.5);
+	}
+	
+	__fx_ready = 1;
+}
+
+fix16 fx_from_real(real _x) { return (fix16) (_x * FX_ONE + (_x < 0 ? -0.5 : 0.5)); }
+real fx_to_real(fix16 _x) { return (real) _x / FX_ONE; }
+
+vec3x vec3x_from_real(vec3f _v) { return (vec3x) {fx_from_real(_v.x), fx_from_real(_v.y), fx_from_real(_v.z)}; }
+vec3f vec3x_to_real(vec3x _v) { return (vec3f) {fx_to_real(_v.x), fx_to_real(_v.y), fx_to_real(_v.z)}; }
+
+/* rounded product */
+fix16 fx_mul(fix16 _a, fix16 _b) { return (fix16) (((int64_t) _a * _b + (1 << 15)) >> 16); }
+
+/* quotient (`_b` must not be 0) */
+fix16 fx_div(fix16 _a, fix16 _b) { return (fix16) (((int64_t) _a << 16) / _b); }
+
+/* internal function that returns r ~ 2^45 / sqrt(m) (Q1.30) where m is `_x`
+ * shifted left by the even amount `*_shift` (negative for right shifts) into
+ * [2^30, 2^32). the table guess gets one newton step, good to about 2^-19.
+ * (`_x` must not be 0) */
+int64_t __fx_rsqrt(uint64_t _x, int* _shift, uint64_t* _m) {
+	int lz = __builtin_clzll(_x);
+	int shift = (lz - 32) & ~1; // leaves 31 or 32 significant bits
+	uint64_t m = shift >= 0 ? _x << shift : _x >> -shift;
+	
+	int64_t r = __fx_rsqrt_lut[m >> (32 - FX_RSQRT_BITS)];
+	
+	// r = r * (3 - m * r^2) / 2, with m * r^2 in Q2.30
+	int64_t mr2 = (int64_t) ((m * r) >> 30) * r >> 30;
+	r = r * ((3LL << 30) - mr2) >> 31;
+	
+	*_shift = shift;
+	*_m = m;
+	return r;
+}
+
+/* reciprocal square root (`_x` must be positive, saturates for tiny `_x`) */
+fix16 fx_rsqrt(fix16 _x) {
+	int shift;
+	uint64_t m;
+	int64_t r = __fx_rsqrt((uint64_t) _x, &shift, &m);
+	
+	// 1 / sqrt(x / 2^16) * 2^16 = r * 2^(shift / 2 - 21)
+	int s = shift / 2 - 21;
+	if (s >= 0) return r > INT32_MAX >> s ? INT32_MAX : (fix16) (r << s);
+	return (fix16) (r >> -s);
+}
+
+/* square root (`_x` must not be negative) */
+fix16 fx_sqrt(fix16 _x) {
+	if (_x <= 0) return 0;
+	
+	int shift;
+	uint64_t m;
+	int64_t r = __fx_rsqrt((uint64_t) _x << 16, &shift, &m);
+	
+	// sqrt(x * 2^16) = m * r / 2^45 / 2^(shift / 2)
+	return (fix16) ((int64_t) m * r >> (45 + shift / 2));
+}
+
+/* arc cosine, `_x` is clamped to [-1, 1] */
+fix16 fx_acos(fix16 _x) {
+	int negate = _x < 0;
+	if (negate) _x = -_x;
+	if (_x > FX_ONE) _x = FX_ONE;
+	
+	// position of s = sqrt(1 - x) in the table, in 1/65536ths of an interval
+	int64_t s = (int64_t) fx_sqrt(FX_ONE - _x) * FX_ACOS_SIZE;
+	int i = (int) (s >> 16);
+	fix16 ret = __fx_acos_lut[i];
+	if (i < FX_ACOS_SIZE)
+		ret += (fix16) (((int64_t) (__fx_acos_lut[i + 1] - ret) * (s & 0xFFFF)) >> 16);
+	
+	return negate ? FX_PI - ret : ret;
+}
+
+vec3x add3x(vec3x _a, vec3x _b) { return (vec3x) {_a.x + _b.x, _a.y + _b.y, _a.z + _b.z}; }
+vec3x sub3x(vec3x _a, vec3x _b) { return (vec3x) {_a.x - _b.x, _a.y - _b.y, _a.z - _b.z}; }
+vec3x mul3x(vec3x _v, fix16 _c) { return (vec3x) {fx_mul(_v.x, _c), fx_mul(_v.y, _c), fx_mul(_v.z, _c)}; }
+
+fix16 dot3x(vec3x _a, vec3x _b) {
+	return (fix16) (((int64_t) _a.x * _b.x + (int64_t) _a.y * _b.y + (int64_t) _a.z * _b.z + (1 << 15)) >> 16);
+}
+
+vec3x cross3x(vec3x _a, vec3x _b) {
+	return (vec3x) {
+		(fix16) (((int64_t) _a.y * _b.z - (int64_t) _a.z * _b.y) >> 16),
+		(fix16) (((int64_t) _a.z * _b.x - (int64_t) _a.x * _b.z) >> 16),
+		(fix16) (((int64_t) _a.x * _b.y - (int64_t) _a.y * _b.x) >> 16),
+	};
+}
+
+/* squared magnitude in Q32.32 (never overflows) */
+uint64_t sqmag3x(vec3x _v) {
+	return (uint64_t) ((int64_t) _v.x * _v.x) + (uint64_t) ((int64_t) _v.y * _v.y) + (uint64_t) ((int64_t) _v.z * _v.z);
+}
+
+fix16 mag3x(vec3x _v) {
+	uint64_t s2 = sqmag3x(_v);
+	if (!s2) return 0;
+	
+	int shift;
+	uint64_t m;
+	int64_t r = __fx_rsqrt(s2, &shift, &m);
+	
+	// sqrt(s2) = m * r / 2^45 / 2^(shift / 2)
+	return (fix16) ((int64_t) m * r >> (45 + shift / 2));
+}
+
+/* normalised vector (the zero vector stays zero) */
+vec3x norm3x(vec3x _v) {
+	uint64_t s2 = sqmag3x(_v);
+	if (!s2) return _v;
+	
+	int shift;
+	uint64_t m;
+	int64_t r = __fx_rsqrt(s2, &shift, &m);
+	
+	// v * 2^16 / sqrt(s2) = v * r * 2^(shift / 2 - 29)
+	int s = 29 - shift / 2;
+	return (vec3x) {(fix16) (_v.x * r >> s), (fix16) (_v.y * r >> s), (fix16) (_v.z * r >> s)};
+}
+
+/* quaternion multiplication (a.k.a. the hamilton product) */
+qtrnx qmulx(qtrnx _a, qtrnx _b) {
+	return (qtrnx) {
+		fx_mul(_a.r, _b.r) - fx_mul(_a.i, _b.i) - fx_mul(_a.j, _b.j) - fx_mul(_a.k, _b.k),
+		fx_mul(_a.r, _b.i) + fx_mul(_a.i, _b.r) + fx_mul(_a.j, _b.k) - fx_mul(_a.k, _b.j),
+		fx_mul(_a.r, _b.j) - fx_mul(_a.i, _b.k) + fx_mul(_a.j, _b.r) + fx_mul(_a.k, _b.i),
+		fx_mul(_a.r, _b.k) + fx_mul(_a.i, _b.j) - fx_mul(_a.j, _b.i) + fx_mul(_a.k, _b.r),
+	};
+}
+
+/* rotates `_p` by the unit quaternion `_q` (same fused form as `qrot`) */
+vec3x qrotx(qtrnx _q, vec3x _p) {
+	vec3x u = {_q.i, _q.j, _q.k};
+	vec3x t = cross3x(u, _p);
+	t = (vec3x) {2 * t.x, 2 * t.y, 2 * t.z};
+	return add3x(add3x(_p, mul3x(t, _q.r)), cross3x(u, t));
+}
+
+#endif
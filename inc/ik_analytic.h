@@ -0,0 +1,192 @@
+#ifndef __INVERSE_KINEMATICS_ANALYTIC_H__
+#define __INVERSE_KINEMATICS_ANALYTIC_H__
+
+/* closed form solvers for short chains. a two bone chain (3 nodes) is a
+ * triangle whose sides are the two bones and the root to target distance, so
+ * the law of cosines places the middle joint directly. the plane the chain
+ * bends in is chosen with a pole: the middle joint ends up on the same side
+ * of the root to target line as the pole. these solvers ignore the joint
+ * limits, `ik_chain_solve` only uses them for poses whose bends fit. */
+
+/* unit vector orthogonal to `_dir` (which must be normalised) pointing
+ * towards `_hint`, or any orthogonal vector if `_hint` is (almost) along
+ * `_dir`. */
+vec3f __ik_bend_normal(vec3f _dir, vec3f _hint) {
+	vec3f n = sub3f(_hint, mul3f(_dir, dot3f(_hint, _dir)));
+	real len = mag3f(n);
+	if (len > 0.000001 * mag3f(_hint)) return mul3f(n, 1 / len);
+	
+	// no usable hint, bend in the plane orthogonal to z (x for chains along z)
+	vec3f up = fabs(_dir.z) < 0.9 ? (vec3f) {0, 0, 1} : (vec3f) {1, 0, 0};
+	n = cross3f(up, _dir);
+	return mul3f(n, 1 / mag3f(n));
+}
+
+/* internal function that places the apex of a triangle with sides `_a` (base
+ * to apex), `_b` (apex to tip) and `_dist` (base to tip, must lie within the
+ * triangle inequality), `_dir` pointing from base to tip and `_normal` towards
+ * the apex. (returns the offset of the apex from the base) */
+vec3f __ik_triangle_apex(real _a, real _b, real _dist, vec3f _dir, vec3f _normal) {
+	real cos_a = (_a * _a + _dist * _dist - _b * _b) / (2 * _a * _dist);
+	CLAMP(cos_a, 1.0, -1.0);
+	real sin_a = sqrt(1 - cos_a * cos_a);
+	return add3f(mul3f(_dir, _a * cos_a), mul3f(_normal, _a * sin_a));
+}
+
+/* clamps a root to target distance to what two bones can span (targets out
+ * of reach end up with a straight or fully folded chain pointing at them) */
+real __ik_reach(real _a, real _b, real _dist) {
+	CLAMP(_dist, _a + _b, fabs(_a - _b));
+	return _dist;
+}
+
+/* internal function that returns the length of the virtual bone from the
+ * root of a three bone chain to its second joint for a root to target
+ * distance of `_dist`: the current one, stretched or folded just enough for
+ * the last bone to reach the target */
+real __ik_three_bone_span(struct ik_node* _n, real _dist) {
+	real a = _n[3].length, b = _n[2].length, c = _n[1].length;
+	real v = mag3f(sub3f(_n[1].pos, _n[3].pos));
+	
+	CLAMP(v, _dist + c, fabs(_dist - c));
+	v = __ik_reach(a, b, v);
+	return v < 0.000001 ? 0.000001 : v;
+}
+
+/* internal function that sets the directions of a chain from its positions */
+void __ik_analytic_rtns(struct ik_chain* _chain) {
+	for (int k = _chain->num_nodes - 1; k > 0; k--) {
+		vec3f bone = sub3f(_chain->nodes[k - 1].pos, _chain->nodes[k].pos);
+		_chain->nodes[k].rtn = mul3f(bone, 1 / _chain->nodes[k].length);
+	}
+	
+	_chain->nodes[0].rtn = _chain->nodes[1].rtn;
+}
+
+/* solves a two bone chain (3 nodes) exactly. the middle joint bends towards
+ * `_pole` (a position), or keeps its current side of the chain if `_pole` is
+ * null. (returns -1 if the chain does not have 3 nodes or the target sits on
+ * the root) */
+int ik_chain_solve_two_bone(struct ik_chain* _chain, vec3f _target, vec3f* _pole, struct ik_solve_result* _res) {
+	if (_chain->num_nodes != 3) return -1;
+	
+	struct ik_node* n = _chain->nodes;
+	real a = n[2].length, b = n[1].length;
+	vec3f root = n[2].pos;
+	vec3f to_target = sub3f(_target, root);
+	real dist = mag3f(to_target);
+	if (dist < 0.0000000001) return -1;
+	
+	vec3f dir = mul3f(to_target, 1 / dist);
+	vec3f normal = __ik_bend_normal(dir, sub3f(_pole ? *_pole : n[1].pos, root));
+	
+	dist = __ik_reach(a, b, dist);
+	n[1].pos = add3f(root, __ik_triangle_apex(a, b, dist, dir, normal));
+	n[0].pos = add3f(root, mul3f(dir, dist));
+	__ik_analytic_rtns(_chain);
+	
+	if (_res) *_res = (struct ik_solve_result) {1, ik_chain_error(_chain, _target)};
+	return 0;
+}
+
+/* solves a three bone chain (4 nodes) in closed form. the redundant degree of
+ * freedom is fixed by keeping the current distance between the root and the
+ * second joint (i.e. the bend of the first joint) and only changing it when
+ * the target can not be reached otherwise, which reduces the chain to two
+ * nested two bone problems. both joints bend towards `_pole`, or keep their
+ * current side if it is null. (returns -1 if the chain does not have 4 nodes
+ * or the target sits on the root) */
+int ik_chain_solve_three_bone(struct ik_chain* _chain, vec3f _target, vec3f* _pole, struct ik_solve_result* _res) {
+	if (_chain->num_nodes != 4) return -1;
+	
+	struct ik_node* n = _chain->nodes;
+	real a = n[3].length, b = n[2].length, c = n[1].length;
+	vec3f root = n[3].pos;
+	vec3f to_target = sub3f(_target, root);
+	real dist = mag3f(to_target);
+	if (dist < 0.0000000001) return -1;
+	
+	vec3f dir = mul3f(to_target, 1 / dist);
+	vec3f hint = _pole ? *_pole : mul3f(add3f(n[1].pos, n[2].pos), 0.5);
+	vec3f normal = __ik_bend_normal(dir, sub3f(hint, root));
+	
+	real v = __ik_three_bone_span(n, dist);
+	dist = __ik_reach(v, c, dist);
+	vec3f to_joint = __ik_triangle_apex(v, c, dist, dir, normal);
+	n[1].pos = add3f(root, to_joint);
+	n[0].pos = add3f(root, mul3f(dir, dist));
+	
+	vec3f joint_dir = mul3f(to_joint, 1 / v);
+	n[2].pos = add3f(root, __ik_triangle_apex(a, b, v, joint_dir, __ik_bend_normal(joint_dir, sub3f(hint, root))));
+	__ik_analytic_rtns(_chain);
+	
+	if (_res) *_res = (struct ik_solve_result) {1, ik_chain_error(_chain, _target)};
+	return 0;
+}
+
+/* internal function that checks every bone of a chain against its limit (the
+ * same limits FABRIK clamps to) */
+int __ik_chain_within_limits(struct ik_chain* _chain) {
+	int last = _chain->num_nodes - 1;
+	real slack = 0.000001;
+	
+	if (!__ik_within_limit(_chain->rtn, &_chain->limit, _chain->nodes[last].rtn, slack)) return 0;
+	
+	for (int k = last - 1; k > 0; k--)
+		if (!__ik_within_limit(_chain->nodes[k + 1].rtn, &_chain->limits[k + 1], _chain->nodes[k].rtn, slack))
+			return 0;
+	
+	return 1;
+}
+
+/* internal function that returns the cosine of the largest bend a limit
+ * allows in every direction (the narrower aperture of an ellipse) */
+real __ik_limit_cos_min(struct ik_limit* _limit) {
+	if (_limit->type != IK_LIMIT_ELLIPSE || _limit->cot_ap_y <= _limit->cot_ap) return _limit->cos_ap;
+	return _limit->cot_ap_y * RSQRT(1 + _limit->cot_ap_y * _limit->cot_ap_y);
+}
+
+/* internal function that tells if two bones `_a` and `_b` whose ends are
+ * `_dist` apart bend little enough at their joint for `_limit`. the bend is
+ * pi minus the angle the law of cosines gives at the joint. */
+int __ik_bend_fits(real _a, real _b, real _dist, struct ik_limit* _limit) {
+	real cos_bend = (_dist * _dist - _a * _a - _b * _b) / (2 * _a * _b);
+	return cos_bend >= __ik_limit_cos_min(_limit);
+}
+
+/* internal function that tells if the closed form pose towards `_target`
+ * could keep the bends of a two or three bone chain within their limits,
+ * before solving (the root bone and the last joint of a three bone chain are
+ * only known afterwards) */
+int __ik_analytic_fits(struct ik_chain* _chain, vec3f _target) {
+	struct ik_node* n = _chain->nodes;
+	int last = _chain->num_nodes - 1;
+	real dist = mag3f(sub3f(_target, n[last].pos));
+	
+	if (last == 2) return __ik_bend_fits(n[2].length, n[1].length, __ik_reach(n[2].length, n[1].length, dist), &_chain->limits[2]);
+	return __ik_bend_fits(n[3].length, n[2].length, __ik_three_bone_span(n, dist), &_chain->limits[3]);
+}
+
+/* solves a chain with the cheapest solver that handles it: two and three bone
+ * chains are solved in closed form if their bends fit their limits, and if
+ * that pose still breaks a limit (or the chain is longer) the pose is
+ * restored and FABRIK used instead. with the default 30 degree apertures
+ * only targets close to full reach are solved in closed form. `_opts` and
+ * `_res` are as for `ik_chain_solve_fabrik`. */
+int ik_chain_solve(struct ik_chain* _chain, vec3f _target, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	if ((_chain->num_nodes == 3 || _chain->num_nodes == 4) && __ik_analytic_fits(_chain, _target)) {
+		struct ik_node saved[4];
+		memcpy(saved, _chain->nodes, _chain->num_nodes * sizeof(struct ik_node));
+		
+		int ret = _chain->num_nodes == 3
+			? ik_chain_solve_two_bone(_chain, _target, 0, _res)
+			: ik_chain_solve_three_bone(_chain, _target, 0, _res);
+		
+		if (ret == 0 && __ik_chain_within_limits(_chain)) return 0;
+		memcpy(_chain->nodes, saved, _chain->num_nodes * sizeof(struct ik_node));
+	}
+	
+	return ik_chain_solve_fabrik(_chain, _target, _opts, _res);
+}
+
+#endif
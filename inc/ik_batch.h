@@ -0,0 +1,235 @@
+#ifndef __INVERSE_KINEMATICS_BATCH_H__
+#define __INVERSE_KINEMATICS_BATCH_H__
+
+#define IK_BATCH_MAX_JOBS 64
+
+struct ik_batch;
+
+/* a slice of a batch solved as one thread pool job */
+struct ik_batch_job {
+	struct ik_batch* batch;
+	vec3f* targets;
+	struct ik_solve_opts* opts;
+	int first, count;
+	real rigidity; // CCD only
+	int ret;
+};
+
+/* a batch owns copies of many chains whose nodes all live in one contiguous
+ * arena, so that solving them walks memory front to back instead of chasing
+ * a separate allocation per chain. chains are appended once (at scene load)
+ * and then solved together every frame. */
+struct ik_batch {
+	struct ik_chain* chains;
+	struct ik_node* nodes; // node arena shared by every chain in the batch
+	struct ik_limit* limits; // limits of every chain, laid out like `nodes`
+	qtrn* pending; // CCD scratch of every chain, laid out like `nodes`
+	struct ik_solve_result* results; // result of the last solve of every chain
+	int num_chains, max_chains;
+	int num_nodes, max_nodes;
+	struct ik_pack pack; // scratch for the lockstep (SIMD) solver
+	struct ik_batch_job jobs[IK_BATCH_MAX_JOBS]; // slices for the threaded solvers
+};
+
+/* allocates a batch able to hold `_max_chains` chains with at most
+ * `_max_nodes` nodes between them. (returns -1 on error) */
+int ik_batch_init(struct ik_batch* _batch, int _max_chains, int _max_nodes) {
+	_batch->num_chains = _batch->num_nodes = 0;
+	_batch->max_chains = _max_chains;
+	_batch->max_nodes = _max_nodes;
+	_batch->pack = (struct ik_pack) {0};
+	
+	_batch->chains = malloc(_max_chains * sizeof(struct ik_chain));
+	_batch->nodes = malloc(_max_nodes * sizeof(struct ik_node));
+	_batch->limits = malloc(_max_nodes * sizeof(struct ik_limit));
+	_batch->pending = malloc(_max_nodes * sizeof(qtrn));
+	_batch->results = calloc(_max_chains, sizeof(struct ik_solve_result));
+	
+	if (!_batch->chains || !_batch->nodes || !_batch->limits || !_batch->pending || !_batch->results) {
+		free(_batch->chains);
+		free(_batch->nodes);
+		free(_batch->limits);
+		free(_batch->pending);
+		free(_batch->results);
+		_batch->chains = 0;
+		_batch->nodes = 0;
+		_batch->limits = 0;
+		_batch->pending = 0;
+		_batch->results = 0;
+		return -1;
+	}
+	
+	return 0;
+}
+
+void ik_batch_free(struct ik_batch* _batch) {
+	ik_pack_free(&_batch->pack);
+	free(_batch->chains);
+	free(_batch->nodes);
+	free(_batch->limits);
+	free(_batch->pending);
+	free(_batch->results);
+	_batch->chains = 0;
+	_batch->nodes = 0;
+	_batch->limits = 0;
+	_batch->pending = 0;
+	_batch->results = 0;
+	_batch->num_chains = _batch->max_chains = 0;
+	_batch->num_nodes = _batch->max_nodes = 0;
+}
+
+/* removes every chain from the batch (the arena is kept for reuse) */
+void ik_batch_clear(struct ik_batch* _batch) {
+	_batch->num_chains = _batch->num_nodes = 0;
+}
+
+/* copies `_chain` into the batch and returns its index, the copy is what
+ * gets solved and can be read back through `_batch->chains[index]`.
+ * (returns -1 if the batch is full) */
+int ik_batch_add_chain(struct ik_batch* _batch, struct ik_chain* _chain) {
+	if (_batch->num_chains >= _batch->max_chains) return -1;
+	if (_batch->num_nodes + _chain->num_nodes > _batch->max_nodes) return -1;
+	
+	// grow the pack scratch here so that solving never allocates
+	if (_chain->num_nodes > _batch->pack.capacity) {
+		ik_pack_free(&_batch->pack);
+		if (ik_pack_alloc(&_batch->pack, _chain->num_nodes) == -1) return -1;
+	}
+	
+	struct ik_chain* c = &_batch->chains[_batch->num_chains];
+	*c = *_chain;
+	c->nodes = _batch->nodes + _batch->num_nodes;
+	c->limits = _batch->limits + _batch->num_nodes;
+	c->pending = _batch->pending + _batch->num_nodes;
+	memcpy(c->nodes, _chain->nodes, _chain->num_nodes * sizeof(struct ik_node));
+	memcpy(c->limits, _chain->limits, _chain->num_nodes * sizeof(struct ik_limit));
+	
+	_batch->num_nodes += _chain->num_nodes;
+	return _batch->num_chains++;
+}
+
+/* solves every chain in the batch towards its target (`_targets[i]` for
+ * chain i) with FABRIK, the outcome for chain i is left in
+ * `_batch->results[i]`. (`_opts` may be null for the defaults) */
+int ik_batch_solve_fabrik(struct ik_batch* _batch, vec3f* _targets, struct ik_solve_opts* _opts) {
+	for (int i = 0; i < _batch->num_chains; i++) {
+		// pull the next chain's nodes in while this one is being solved
+		if (i + 1 < _batch->num_chains)
+			__builtin_prefetch(_batch->chains[i + 1].nodes);
+		
+		ik_chain_solve_fabrik(&_batch->chains[i], _targets[i], _opts, &_batch->results[i]);
+	}
+	
+	return 0;
+}
+
+/* same as `ik_batch_solve_fabrik`, but runs of `ik_simd_width()` adjacent
+ * chains with the same number of nodes are solved in lockstep, one chain per
+ * vector lane (group equally sized chains together when filling the batch).
+ * packs only clamp to cones, so chains with an elliptical limit are left to
+ * the scalar solver. poses can differ from the scalar solver by rounding. */
+int ik_batch_solve_fabrik_simd(struct ik_batch* _batch, vec3f* _targets, struct ik_solve_opts* _opts) {
+	int width = ik_simd_width();
+	if (width == 1) return ik_batch_solve_fabrik(_batch, _targets, _opts);
+	
+	for (int j, i = 0; i < _batch->num_chains; i = j) {
+		short num_nodes = _batch->chains[i].num_nodes;
+		for (j = i + 1; j < _batch->num_chains && j - i < width; j++)
+			if (_batch->chains[j].num_nodes != num_nodes || __ik_chain_has_ellipse(&_batch->chains[j])) break;
+		
+		// not enough chains to fill every lane
+		if (j - i < width || __ik_chain_has_ellipse(&_batch->chains[i])) {
+			for (int k = i; k < j; k++)
+				ik_chain_solve_fabrik(&_batch->chains[k], _targets[k], _opts, &_batch->results[k]);
+			continue;
+		}
+		
+		ik_pack_load(&_batch->pack, &_batch->chains[i], width);
+		ik_pack_solve_fabrik(&_batch->pack, &_targets[i], _opts, &_batch->results[i]);
+		ik_pack_store(&_batch->pack, &_batch->chains[i]);
+	}
+	
+	return 0;
+}
+
+/* solves every chain in the batch towards its target (`_targets[i]` for
+ * chain i) with CCD, the outcome for chain i is left in `_batch->results[i]`.
+ * every chain is solved even if some fail. (returns -1 if any chain failed) */
+int ik_batch_solve_ccd(struct ik_batch* _batch, vec3f* _targets, real _rigidity, struct ik_solve_opts* _opts) {
+	int ret = 0;
+	
+	for (int i = 0; i < _batch->num_chains; i++) {
+		if (i + 1 < _batch->num_chains)
+			__builtin_prefetch(_batch->chains[i + 1].nodes);
+		
+		if (ik_chain_solve_ccd(&_batch->chains[i], _targets[i], _rigidity, _opts, &_batch->results[i]) == -1)
+			ret = -1;
+	}
+	
+	return ret;
+}
+
+void __ik_batch_fabrik_job(void* _arg) {
+	struct ik_batch_job* job = _arg;
+	struct ik_chain* chains = job->batch->chains;
+	struct ik_solve_result* results = job->batch->results;
+	
+	for (int i = job->first; i < job->first + job->count; i++)
+		ik_chain_solve_fabrik(&chains[i], job->targets[i], job->opts, &results[i]);
+	
+	job->ret = 0;
+}
+
+void __ik_batch_ccd_job(void* _arg) {
+	struct ik_batch_job* job = _arg;
+	struct ik_chain* chains = job->batch->chains;
+	struct ik_solve_result* results = job->batch->results;
+	
+	job->ret = 0;
+	for (int i = job->first; i < job->first + job->count; i++)
+		if (ik_chain_solve_ccd(&chains[i], job->targets[i], job->rigidity, job->opts, &results[i]) == -1)
+			job->ret = -1;
+}
+
+/* splits the batch into slices (a few per worker, so that stealing can even
+ * out chains of different lengths), runs `_fn` on each of them through
+ * `_pool` and waits for them all. */
+int __ik_batch_run_jobs(struct ik_batch* _batch, vec3f* _targets, real _rigidity, struct ik_solve_opts* _opts, struct tp_pool* _pool, void (*_fn)(void*)) {
+	int num_jobs = _pool->num_workers * 4;
+	if (num_jobs > IK_BATCH_MAX_JOBS) num_jobs = IK_BATCH_MAX_JOBS;
+	if (num_jobs > _batch->num_chains) num_jobs = _batch->num_chains;
+	
+	for (int first = 0, i = 0; i < num_jobs; i++) {
+		struct ik_batch_job* job = &_batch->jobs[i];
+		int count = (_batch->num_chains - first) / (num_jobs - i);
+		
+		*job = (struct ik_batch_job) {_batch, _targets, _opts, first, count, _rigidity, 0};
+		first += count;
+		
+		// run it here if the pool's queue is full
+		if (tp_submit(_pool, _fn, job) == -1) _fn(job);
+	}
+	
+	tp_wait(_pool);
+	
+	int ret = 0;
+	for (int i = 0; i < num_jobs; i++)
+		if (_batch->jobs[i].ret == -1) ret = -1;
+	
+	return ret;
+}
+
+/* same as `ik_batch_solve_fabrik`, but the chains are spread across the
+ * workers of `_pool` (which should be able to queue `IK_BATCH_MAX_JOBS`). */
+int ik_batch_solve_fabrik_mt(struct ik_batch* _batch, vec3f* _targets, struct ik_solve_opts* _opts, struct tp_pool* _pool) {
+	return __ik_batch_run_jobs(_batch, _targets, 0, _opts, _pool, __ik_batch_fabrik_job);
+}
+
+/* same as `ik_batch_solve_ccd`, but the chains are spread across the
+ * workers of `_pool` (which should be able to queue `IK_BATCH_MAX_JOBS`).
+ * (returns -1 if any chain failed) */
+int ik_batch_solve_ccd_mt(struct ik_batch* _batch, vec3f* _targets, real _rigidity, struct ik_solve_opts* _opts, struct tp_pool* _pool) {
+	return __ik_batch_run_jobs(_batch, _targets, _rigidity, _opts, _pool, __ik_batch_ccd_job);
+}
+
+#endif
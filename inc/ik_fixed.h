@@ -0,0 +1,166 @@
+#ifndef __INVERSE_KINEMATICS_FIXED_H__
+#define __INVERSE_KINEMATICS_FIXED_H__
+
+#include "fixed.h"
+
+/* Q16.16 copy of a chain for FABRIK on targets without an FPU. node `i` here
+ * is node `i` of the `struct ik_chain` it was made from. only circular limits
+ * are supported, elliptical ones are solved as a cone of their `aperture`.
+ * converting from and to the floating point chain is the only place that
+ * touches floats, the solve itself is integer only. */
+struct ik_node_fx {
+	fix16 length;
+	fix16 cos_ap, sin_ap;
+	vec3x pos;
+	vec3x rtn;
+};
+
+struct ik_chain_fx {
+	struct ik_node_fx* nodes;
+	short num_nodes;
+	fix16 cos_ap, sin_ap;
+	vec3x rtn;
+};
+
+/* same as `struct ik_solve_opts` and `struct ik_solve_result`, in Q16.16 */
+struct ik_solve_opts_fx {
+	int max_iterations;
+	fix16 tolerance;
+	fix16 min_improvement;
+};
+
+struct ik_solve_result_fx {
+	int iterations;
+	fix16 error;
+};
+
+// 0.001 and the smallest step there is (1/65536)
+#define IK_FX_DEFAULTS ((struct ik_solve_opts_fx) {100, 66, 1})
+
+/* allocates `_fx` and fills it with the contents of `_chain` (also builds the
+ * lookup tables of inc/fixed.h). (returns -1 on error) */
+int ik_chain_to_fx(struct ik_chain_fx* _fx, struct ik_chain* _chain) {
+	_fx->nodes = malloc(_chain->num_nodes * sizeof(struct ik_node_fx));
+	if (!_fx->nodes) return -1;
+	
+	fx_init();
+	_fx->num_nodes = _chain->num_nodes;
+	_fx->cos_ap = fx_from_real(_chain->limit.cos_ap);
+	_fx->sin_ap = fx_from_real(_chain->limit.sin_ap);
+	_fx->rtn = vec3x_from_real(_chain->rtn);
+	
+	for (int i = 0; i < _chain->num_nodes; i++) {
+		struct ik_node* n = &_chain->nodes[i];
+		_fx->nodes[i] = (struct ik_node_fx) {
+			fx_from_real(n->length),
+			fx_from_real(_chain->limits[i].cos_ap),
+			fx_from_real(_chain->limits[i].sin_ap),
+			vec3x_from_real(n->pos),
+			vec3x_from_real(n->rtn),
+		};
+	}
+	
+	return 0;
+}
+
+/* writes the positions and directions of `_fx` back into `_chain`.
+ * (returns -1 if the chains differ in length) */
+int ik_fx_to_chain(struct ik_chain* _chain, struct ik_chain_fx* _fx) {
+	if (_chain->num_nodes != _fx->num_nodes) return -1;
+	
+	for (int i = 0; i < _fx->num_nodes; i++) {
+		_chain->nodes[i].pos = vec3x_to_real(_fx->nodes[i].pos);
+		_chain->nodes[i].rtn = vec3x_to_real(_fx->nodes[i].rtn);
+	}
+	
+	ik_chain_invalidate(_chain);
+	return 0;
+}
+
+void ik_chain_fx_free(struct ik_chain_fx* _fx) {
+	free(_fx->nodes);
+	_fx->nodes = 0;
+	_fx->num_nodes = 0;
+}
+
+/* distance between the effector of a chain and `_target` */
+fix16 ik_chain_fx_error(struct ik_chain_fx* _fx, vec3x _target) {
+	return mag3x(sub3x(_fx->nodes[0].pos, _target));
+}
+
+/* integer version of `__ik_clamp_vector_to_cone` */
+vec3x __ik_fx_clamp_to_cone(vec3x _axis, fix16 _cos_ap, fix16 _sin_ap, vec3x _v) {
+	if (dot3x(_axis, _v) >= _cos_ap) return _v;
+	
+	vec3x perp = cross3x(cross3x(_axis, _v), _axis);
+	if (!perp.x && !perp.y && !perp.z)
+		perp = cross3x(_axis, _axis.x < FX_ONE / 2 && _axis.x > -FX_ONE / 2 ? (vec3x) {FX_ONE, 0, 0} : (vec3x) {0, FX_ONE, 0});
+	
+	perp = norm3x(perp);
+	return add3x(mul3x(_axis, _cos_ap), mul3x(perp, _sin_ap));
+}
+
+/* integer version of `ik_chain_solve_fabrik`. `_opts` may be null to use
+ * `IK_FX_DEFAULTS`, and `_res` may be null. */
+int ik_chain_fx_solve_fabrik(struct ik_chain_fx* _fx, vec3x _target, struct ik_solve_opts_fx* _opts, struct ik_solve_result_fx* _res) {
+	struct ik_node_fx* nodes = _fx->nodes;
+	int last = _fx->num_nodes - 1;
+	vec3x target; // current target position (not always `_target`)
+	vec3x joint_vec; // vector from joint to current target
+	vec3x root = nodes[last].pos;
+	
+	struct ik_solve_opts_fx opts = _opts ? *_opts : IK_FX_DEFAULTS;
+	fix16 error = ik_chain_fx_error(_fx, _target);
+	int k, i;
+	
+	for (i = 0; i < opts.max_iterations && error > opts.tolerance; ) {
+		// forward pass
+		target = nodes[0].pos = _target;
+		
+		joint_vec = norm3x(sub3x(target, nodes[1].pos));
+		target = sub3x(target, mul3x(joint_vec, nodes[1].length));
+		nodes[1].pos = target;
+		nodes[1].rtn = joint_vec;
+		
+		for (k = 1; k < last - 1; k++) {
+			joint_vec = norm3x(sub3x(target, nodes[k + 1].pos));
+			joint_vec = __ik_fx_clamp_to_cone(nodes[k].rtn, nodes[k].cos_ap, nodes[k].sin_ap, joint_vec);
+			
+			target = sub3x(target, mul3x(joint_vec, nodes[k + 1].length));
+			nodes[k + 1].pos = target;
+			nodes[k + 1].rtn = joint_vec;
+		}
+		
+		// backward pass
+		target = nodes[last].pos = root;
+		
+		joint_vec = norm3x(sub3x(nodes[last - 1].pos, target));
+		joint_vec = __ik_fx_clamp_to_cone(_fx->rtn, _fx->cos_ap, _fx->sin_ap, joint_vec);
+		target = add3x(target, mul3x(joint_vec, nodes[last].length));
+		nodes[last - 1].pos = target;
+		nodes[last].rtn = joint_vec;
+		
+		for (k = last - 1; k > 0; k--) {
+			joint_vec = norm3x(sub3x(nodes[k - 1].pos, target));
+			joint_vec = __ik_fx_clamp_to_cone(nodes[k + 1].rtn, nodes[k + 1].cos_ap, nodes[k + 1].sin_ap, joint_vec);
+			
+			target = add3x(target, mul3x(joint_vec, nodes[k].length));
+			nodes[k - 1].pos = target;
+			nodes[k].rtn = joint_vec;
+		}
+		
+		// set effector rotation
+		nodes[0].rtn = nodes[1].rtn;
+		
+		// stop early once an iteration no longer gets the effector closer
+		i++;
+		fix16 last_error = error;
+		error = ik_chain_fx_error(_fx, _target);
+		if (last_error - error < opts.min_improvement) break;
+	}
+	
+	if (_res) *_res = (struct ik_solve_result_fx) {i, error};
+	return 0;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef __INVERSE_KINEMATICS_FK_H__
+#define __INVERSE_KINEMATICS_FK_H__
+
+/* incremental forward kinematics. rotating joint k of a chain moves every
+ * node below it (towards the effector), so applying each rotation right away
+ * costs O(k). instead the rotation is kept as a pending local rotation of
+ * joint k and only the effector is moved, the directions and positions of
+ * the nodes in between are brought up to date in one pass from the highest
+ * dirty joint down when they are read (or on `ik_fk_flush`). a sweep over
+ * the chain from the effector towards the root (as in CCD) never reads a
+ * dirty node, so it costs O(n) instead of O(n^2). */
+struct ik_fk {
+	struct ik_chain* chain;
+	qtrn* pending; // rotation of joint k not yet applied to the nodes below it
+	short dirty; // highest joint with a pending rotation (0 if none)
+	vec3f effector; // position of node 0, always up to date
+};
+
+/* tracks `_chain`, with `_pending` room for `_chain->num_nodes` rotations.
+ * the chain must not be changed behind the tracker's back until the next
+ * `ik_fk_flush`. */
+void ik_fk_init(struct ik_fk* _fk, struct ik_chain* _chain, qtrn* _pending) {
+	_fk->chain = _chain;
+	_fk->pending = _pending;
+	_fk->dirty = 0;
+	_fk->effector = _chain->nodes[0].pos;
+	
+	for (int k = 0; k < _chain->num_nodes; k++) _pending[k] = (qtrn) {1, 0, 0, 0};
+}
+
+/* applies every pending rotation, after which the chain's nodes can be read
+ * directly again */
+void ik_fk_flush(struct ik_fk* _fk) {
+	struct ik_node* nodes = _fk->chain->nodes;
+	qtrn acc = {1, 0, 0, 0}; // every pending rotation above the current node
+	
+	if (!_fk->dirty) return;
+	
+	for (int k = _fk->dirty; k > 0; k--) {
+		acc = qmul(acc, _fk->pending[k]);
+		_fk->pending[k] = (qtrn) {1, 0, 0, 0};
+		
+		nodes[k].rtn = norm3f(qrot(acc, nodes[k].rtn));
+		nodes[k - 1].pos = add3f(nodes[k].pos, mul3f(nodes[k].rtn, nodes[k].length));
+	}
+	
+	nodes[0].rtn = norm3f(qrot(acc, nodes[0].rtn));
+	_fk->effector = nodes[0].pos;
+	_fk->dirty = 0;
+}
+
+/* world position of node `_k` (flushes if it is out of date) */
+vec3f ik_fk_pos(struct ik_fk* _fk, short _k) {
+	if (_k < _fk->dirty) ik_fk_flush(_fk);
+	return _fk->chain->nodes[_k].pos;
+}
+
+/* world direction of node `_k` (flushes if it is out of date) */
+vec3f ik_fk_rtn(struct ik_fk* _fk, short _k) {
+	if (_k <= _fk->dirty) ik_fk_flush(_fk);
+	return _fk->chain->nodes[_k].rtn;
+}
+
+/* rotates the part of the chain below joint `_k` (`_k` > 0) by `_rot` about
+ * the joint. only the effector is moved now, the rest is left pending.
+ * (rotating below the highest dirty joint flushes first, pending rotations
+ * below `_k` would have to be applied before this one) */
+void ik_fk_rotate(struct ik_fk* _fk, short _k, qtrn _rot) {
+	vec3f pivot = ik_fk_pos(_fk, _k);
+	
+	_fk->pending[_k] = qmul(_rot, _fk->pending[_k]);
+	_fk->effector = add3f(pivot, qrot(_rot, sub3f(_fk->effector, pivot)));
+	_fk->dirty = _k;
+}
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef __INVERSE_KINEMATICS_JACOBIAN_H__
+#define __INVERSE_KINEMATICS_JACOBIAN_H__
+
+/* jacobian based solvers. every joint between two bones is a ball joint with
+ * three degrees of freedom (small rotations about the world axes), and any
+ * node of the chain can be pulled towards a target, not just the effector,
+ * so several targets are balanced against each other in a least squares
+ * sense instead of one after the other. */
+
+/* a position the node `node` (0 being the effector) should reach */
+struct ik_target {
+	short node;
+	vec3f pos;
+};
+
+/* preallocated buffers for solving chains of up to `max_nodes` nodes towards
+ * up to `max_targets` targets, a solve itself never allocates. */
+struct ik_jacobian {
+	short max_nodes;
+	int max_targets;
+	real* jac; // jacobian, one row per target coordinate, one column per joint axis
+	real* jjt; // jac * jac^T plus damping, and later its cholesky factor
+	real* err; // clamped error of every target
+	real* tmp; // jac * jac^T * err (transpose method), solution of the normal equations (DLS)
+	real* dtheta; // joint rotation of this iteration
+};
+
+#define IK_JACOBIAN_DEFAULTS ((struct ik_solve_opts) {100, 0.001, 0.000001})
+#define IK_JACOBIAN_STALLS 4 // iterations in a row without improvement that end a solve
+
+/* allocates a workspace for chains of up to `_max_nodes` nodes and up to
+ * `_max_targets` targets. (returns -1 on error) */
+int ik_jacobian_alloc(struct ik_jacobian* _ws, short _max_nodes, int _max_targets) {
+	int rows = 3 * _max_targets;
+	int cols = 3 * (_max_nodes - 1);
+	real* block = malloc((rows * cols + rows * rows + 2 * rows + cols) * sizeof(real));
+	if (!block) return -1;
+	
+	_ws->max_nodes = _max_nodes;
+	_ws->max_targets = _max_targets;
+	_ws->jac = block;
+	_ws->jjt = _ws->jac + rows * cols;
+	_ws->err = _ws->jjt + rows * rows;
+	_ws->tmp = _ws->err + rows;
+	_ws->dtheta = _ws->tmp + rows;
+	
+	return 0;
+}
+
+void ik_jacobian_free(struct ik_jacobian* _ws) {
+	free(_ws->jac);
+	_ws->jac = _ws->jjt = _ws->err = _ws->tmp = _ws->dtheta = 0;
+	_ws->max_nodes = _ws->max_targets = 0;
+}
+
+/* largest distance between a target and its node */
+real ik_chain_error_targets(struct ik_chain* _chain, struct ik_target* _targets, int _num_targets) {
+	real error = 0;
+	
+	for (int t = 0; t < _num_targets; t++) {
+		real d = mag3f(sub3f(_chain->nodes[_targets[t].node].pos, _targets[t].pos));
+		if (d > error) error = d;
+	}
+	
+	return error;
+}
+
+/* internal function that fills the jacobian and the error vector. the
+ * column of joint k about axis a is `a x (node - pos[k])` for every target
+ * node downstream of k (nodes towards the effector), and zero otherwise. */
+void __ik_jacobian_build(struct ik_chain* _chain, struct ik_jacobian* _ws, struct ik_target* _targets, int _num_targets) {
+	int cols = 3 * (_chain->num_nodes - 1);
+	
+	// errors are clamped to a bone length so that one far target can not
+	// swamp the linearisation
+	real max_step = 0;
+	for (int k = 1; k < _chain->num_nodes; k++) max_step += _chain->nodes[k].length;
+	max_step /= _chain->num_nodes - 1;
+	
+	for (int t = 0; t < _num_targets; t++) {
+		vec3f node = _chain->nodes[_targets[t].node].pos;
+		vec3f e = sub3f(_targets[t].pos, node);
+		real mag = mag3f(e);
+		if (mag > max_step) e = mul3f(e, max_step / mag);
+		
+		_ws->err[3 * t + 0] = e.x;
+		_ws->err[3 * t + 1] = e.y;
+		_ws->err[3 * t + 2] = e.z;
+		
+		real* row = &_ws->jac[3 * t * cols];
+		
+		for (int k = 1; k < _chain->num_nodes; k++) {
+			real* col = &row[3 * (k - 1)];
+			
+			if (k <= _targets[t].node) {
+				for (int r = 0; r < 3; r++) col[r * cols + 0] = col[r * cols + 1] = col[r * cols + 2] = 0;
+				continue;
+			}
+			
+			vec3f d = sub3f(node, _chain->nodes[k].pos);
+			
+			// x cross d, y cross d, z cross d
+			col[0 * cols + 0] = 0;    col[0 * cols + 1] = d.z;  col[0 * cols + 2] = -d.y;
+			col[1 * cols + 0] = -d.z; col[1 * cols + 1] = 0;    col[1 * cols + 2] = d.x;
+			col[2 * cols + 0] = d.y;  col[2 * cols + 1] = -d.x; col[2 * cols + 2] = 0;
+		}
+	}
+}
+
+/* internal function that rotates every joint by `_ws->dtheta` and rebuilds
+ * the node positions from the root, keeping each bone inside its limit */
+void __ik_jacobian_apply(struct ik_chain* _chain, struct ik_jacobian* _ws) {
+	int last = _chain->num_nodes - 1;
+	qtrn acc = {1, 0, 0, 0}; // rotation of every joint so far (root first)
+	
+	for (int k = last; k > 0; k--) {
+		vec3f w = {_ws->dtheta[3 * (k - 1)], _ws->dtheta[3 * (k - 1) + 1], _ws->dtheta[3 * (k - 1) + 2]};
+		real phi = mag3f(w);
+		if (phi > 0.0000000001) acc = qmul(make_qrot(mul3f(w, 1 / phi), phi), acc);
+		
+		vec3f rtn = norm3f(qrot(acc, _chain->nodes[k].rtn));
+		rtn = k == last
+			? __ik_clamp_vector_to_limit(_chain->rtn, &_chain->limit, rtn)
+			: __ik_clamp_vector_to_limit(_chain->nodes[k + 1].rtn, &_chain->limits[k + 1], rtn);
+		
+		_chain->nodes[k].rtn = rtn;
+		_chain->nodes[k - 1].pos = add3f(_chain->nodes[k].pos, mul3f(rtn, _chain->nodes[k].length));
+	}
+	
+	_chain->nodes[0].rtn = _chain->nodes[1].rtn;
+}
+
+/* internal function shared by the jacobian solvers, a negative `_damping`
+ * selects the transpose method. */
+int __ik_chain_solve_jacobian(struct ik_chain* _chain, struct ik_jacobian* _ws, struct ik_target* _targets, int _num_targets, real _damping, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	if (_chain->num_nodes > _ws->max_nodes || _num_targets > _ws->max_targets) return -1;
+	for (int t = 0; t < _num_targets; t++)
+		if (_targets[t].node < 0 || _targets[t].node >= _chain->num_nodes - 1) return -1;
+	
+	struct ik_solve_opts opts = _opts ? *_opts : IK_JACOBIAN_DEFAULTS;
+	int rows = 3 * _num_targets;
+	int cols = 3 * (_chain->num_nodes - 1);
+	real error = ik_chain_error_targets(_chain, _targets, _num_targets);
+	real damping = _damping;
+	int i, stalls = 0;
+	
+	for (i = 0; i < opts.max_iterations && error > opts.tolerance; ) {
+		__ik_jacobian_build(_chain, _ws, _targets, _num_targets);
+		
+		if (_damping < 0) {
+			// dtheta = alpha * J^T * e, with alpha minimising the linearised error
+			dense_atv(_ws->dtheta, _ws->jac, _ws->err, rows, cols);
+			dense_av(_ws->tmp, _ws->jac, _ws->dtheta, rows, cols);
+			
+			real num = 0, denom = 0;
+			for (int r = 0; r < rows; r++) {
+				num += _ws->err[r] * _ws->tmp[r];
+				denom += _ws->tmp[r] * _ws->tmp[r];
+			}
+			
+			real alpha = denom > 0 ? num / denom : 0;
+			for (int c = 0; c < cols; c++) _ws->dtheta[c] *= alpha;
+		}
+		else {
+			// dtheta = J^T * (J * J^T + damping^2 * I)^-1 * e
+			dense_aat(_ws->jjt, _ws->jac, rows, cols);
+			for (int r = 0; r < rows; r++) _ws->jjt[r * rows + r] += damping * damping;
+			if (dense_cholesky(_ws->jjt, rows) == -1) return -1;
+			
+			memcpy(_ws->tmp, _ws->err, rows * sizeof(real));
+			dense_cholesky_solve(_ws->jjt, _ws->tmp, rows);
+			dense_atv(_ws->dtheta, _ws->jac, _ws->tmp, rows, cols);
+		}
+		
+		__ik_jacobian_apply(_chain, _ws);
+		
+		// stop early once iterations no longer get the nodes closer. a single
+		// stalled step is normal near singular poses (e.g. leaving a straight
+		// chain), where damped least squares overshoots until the damping is
+		// raised, so it takes IK_JACOBIAN_STALLS of them in a row
+		i++;
+		real last_error = error;
+		error = ik_chain_error_targets(_chain, _targets, _num_targets);
+		if (last_error - error >= opts.min_improvement) {
+			stalls = 0;
+			if (damping > _damping) damping *= 0.5;
+			if (damping < _damping) damping = _damping;
+		} else {
+			if (++stalls == IK_JACOBIAN_STALLS) break;
+			damping *= 2;
+		}
+	}
+	
+	if (_res) *_res = (struct ik_solve_result) {i, error};
+	return 0;
+}
+
+/* solves a chain towards `_num_targets` targets with the jacobian transpose
+ * method (cheap iterations, but many of them). `_ws` must be large enough for
+ * the chain and the targets, which may not include the root. `_opts` may be
+ * null to use `IK_JACOBIAN_DEFAULTS`, and `_res` may be null.
+ * (returns -1 on error) */
+int ik_chain_solve_jt(struct ik_chain* _chain, struct ik_jacobian* _ws, struct ik_target* _targets, int _num_targets, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	return __ik_chain_solve_jacobian(_chain, _ws, _targets, _num_targets, -1, _opts, _res);
+}
+
+/* same as `ik_chain_solve_jt` but with damped least squares, which converges
+ * in far fewer iterations when tracking a moving target (2 to 3 in
+ * `make bench_solvers`). from a singular pose (e.g. the straight chain) its
+ * first steps overshoot, the damping is doubled after every step that does
+ * not help and eased back to `_damping` after every one that does, and cold
+ * solves take 20 to 70 iterations and do not always converge. `_damping`
+ * trades accuracy for stability, and is in the same units as the bone
+ * lengths. (returns -1 on error) */
+int ik_chain_solve_dls(struct ik_chain* _chain, struct ik_jacobian* _ws, struct ik_target* _targets, int _num_targets, real _damping, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	return __ik_chain_solve_jacobian(_chain, _ws, _targets, _num_targets, fabs(_damping), _opts, _res);
+}
+
+#endif
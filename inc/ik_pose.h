@@ -0,0 +1,342 @@
+#ifndef __INVERSE_KINEMATICS_POSE_H__
+#define __INVERSE_KINEMATICS_POSE_H__
+
+/* pose snapshots of a chain and files of pose sequences. a frame holds the
+ * pose of every node of a chain in one of these encodings:
+ *
+ *     IK_POSE_NODES   the `struct ik_node`s themselves, which a chain can use
+ *                     in place (see `ik_pose_view`), lossless
+ *     IK_POSE_REAL    `struct ik_node_pose`s, lossless
+ *     IK_POSE_HALF    directions as float16, 6 bytes a node, plus the root
+ *                     position
+ *     IK_POSE_QUANT   directions octahedral-encoded in two int16s, 4 bytes a
+ *                     node, plus the root position
+ *
+ * the last two rebuild the positions from the directions and the bone lengths
+ * of the chain (float16 positions would be off by up to half a unit a few
+ * hundred units from the origin). each direction is stored towards the next
+ * node from where the decoder will have put the current one, so rounding does
+ * not add up along the chain.
+ *
+ * a pose file is a `struct ik_pose_header` followed by `num_frames` frames
+ * of `frame_size` bytes, every frame starts 16 byte aligned so the whole file
+ * can be mapped and read in place. files are only portable between builds
+ * with the same `real` (and for `IK_POSE_NODES` the same `struct ik_node`). */
+
+enum {IK_POSE_NODES, IK_POSE_REAL, IK_POSE_HALF, IK_POSE_QUANT};
+
+#define IK_POSE_MAGIC "IKPS"
+#define IK_POSE_VERSION 2
+#define IK_POSE_ALIGN 16
+
+struct ik_pose_header {
+	char magic[4];
+	uint16_t version;
+	uint16_t encoding;
+	uint16_t real_size;
+	uint16_t node_size;
+	uint32_t num_nodes;
+	uint32_t num_frames;
+	uint32_t frame_size;
+	uint32_t reserved[2]; // pads the header to 32 bytes
+};
+
+/* a mapped pose file */
+struct ik_pose_file {
+	int fd;
+	char* map;
+	size_t size;
+	struct ik_pose_header* header;
+};
+
+/* internal function that converts to float16, rounding to nearest even */
+uint16_t __ik_half(float _x) {
+	uint32_t u;
+	memcpy(&u, &_x, sizeof(u));
+	
+	uint16_t sign = (u >> 16) & 0x8000;
+	int e = (int) ((u >> 23) & 0xFF) - 127 + 15;
+	uint32_t m = u & 0x7FFFFF;
+	
+	if (((u >> 23) & 0xFF) == 0xFF) return sign | 0x7C00 | (m ? 0x200 : 0); // inf and nan
+	if (e >= 31) return sign | 0x7C00;
+	
+	// subnormal halves, h = (m | 1 << 23) * 2^(e - 14)
+	if (e <= 0) {
+		if (e < -10) return sign;
+		
+		int s = 14 - e;
+		m |= 0x800000;
+		uint32_t h = m >> s, rem = m & ((1u << s) - 1), half = 1u << (s - 1);
+		if (rem > half || (rem == half && (h & 1))) h++;
+		return sign | h;
+	}
+	
+	// a carry out of the mantissa correctly bumps the exponent
+	uint32_t h = (uint32_t) e << 10 | m >> 13, rem = m & 0x1FFF;
+	if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) h++;
+	return sign | h;
+}
+
+/* internal function that converts from float16 */
+float __ik_unhalf(uint16_t _h) {
+	uint32_t sign = (uint32_t) (_h & 0x8000) << 16;
+	uint32_t e = (_h >> 10) & 0x1F, m = _h & 0x3FF, u;
+	
+	if (!e) {
+		float x = m * (1.0f / (1 << 24));
+		return sign ? -x : x;
+	}
+	
+	u = e == 31 ? sign | 0x7F800000 | m << 13 : sign | (e + 112) << 23 | m << 13;
+	
+	float x;
+	memcpy(&x, &u, sizeof(x));
+	return x;
+}
+
+/* internal function that folds the lower half of the octahedron onto the
+ * upper one (it is its own inverse) */
+void __ik_oct_fold(real* _x, real* _y) {
+	real x = (1 - FABS(*_y)) * (*_x >= 0 ? 1 : -1);
+	*_y = (1 - FABS(*_x)) * (*_y >= 0 ? 1 : -1);
+	*_x = x;
+}
+
+/* internal function that encodes a unit vector as two int16s */
+void __ik_oct_encode(vec3f _v, int16_t* _out) {
+	real l1 = FABS(_v.x) + FABS(_v.y) + FABS(_v.z);
+	real x = l1 > 0 ? _v.x / l1 : 0, y = l1 > 0 ? _v.y / l1 : 0;
+	
+	if (_v.z < 0) __ik_oct_fold(&x, &y);
+	
+	_out[0] = (int16_t) lrint(x * 32767);
+	_out[1] = (int16_t) lrint(y * 32767);
+}
+
+/* internal function that decodes `__ik_oct_encode` */
+vec3f __ik_oct_decode(const int16_t* _in) {
+	real x = _in[0] / (real) 32767, y = _in[1] / (real) 32767;
+	real z = 1 - FABS(x) - FABS(y);
+	
+	if (z < 0) __ik_oct_fold(&x, &y);
+	
+	return norm3f((vec3f) {x, y, z});
+}
+
+/* internal function that reads direction `_k` of an `IK_POSE_HALF` or
+ * `IK_POSE_QUANT` frame from `_dirs`, which follow the root position */
+vec3f __ik_pose_get_dir(int _encoding, const void* _dirs, int _k) {
+	if (_encoding == IK_POSE_QUANT) return __ik_oct_decode((const int16_t*) _dirs + 2 * _k);
+	
+	const uint16_t* h = (const uint16_t*) _dirs + 3 * _k;
+	return norm3f((vec3f) {__ik_unhalf(h[0]), __ik_unhalf(h[1]), __ik_unhalf(h[2])});
+}
+
+/* internal function that stores `_v` as direction `_k` of an `IK_POSE_HALF`
+ * or `IK_POSE_QUANT` frame. (returns the direction as it will be read) */
+vec3f __ik_pose_put_dir(int _encoding, void* _dirs, int _k, vec3f _v) {
+	if (_encoding == IK_POSE_QUANT) __ik_oct_encode(_v, (int16_t*) _dirs + 2 * _k);
+	else {
+		uint16_t* h = (uint16_t*) _dirs + 3 * _k;
+		h[0] = __ik_half(_v.x);
+		h[1] = __ik_half(_v.y);
+		h[2] = __ik_half(_v.z);
+	}
+	
+	return __ik_pose_get_dir(_encoding, _dirs, _k);
+}
+
+/* bytes of a frame of `_num_nodes` nodes (0 for an unknown encoding) */
+size_t ik_pose_frame_size(int _encoding, int _num_nodes) {
+	size_t size = 0;
+	
+	switch (_encoding) {
+		case IK_POSE_NODES: size = _num_nodes * sizeof(struct ik_node); break;
+		case IK_POSE_REAL: size = _num_nodes * sizeof(struct ik_node_pose); break;
+		case IK_POSE_HALF: size = 3 * sizeof(float) + _num_nodes * 3 * sizeof(uint16_t); break;
+		case IK_POSE_QUANT: size = 3 * sizeof(float) + _num_nodes * 2 * sizeof(int16_t); break;
+		default: return 0;
+	}
+	
+	return (size + IK_POSE_ALIGN - 1) & ~(size_t) (IK_POSE_ALIGN - 1);
+}
+
+/* stores the pose of `_chain` in `_frame` (`ik_pose_frame_size` bytes) */
+void ik_pose_encode(struct ik_chain* _chain, int _encoding, void* _frame) {
+	struct ik_node* nodes = _chain->nodes;
+	int n = _chain->num_nodes;
+	
+	switch (_encoding) {
+		case IK_POSE_NODES:
+			memcpy(_frame, nodes, n * sizeof(struct ik_node));
+			break;
+		case IK_POSE_REAL:
+			__ik_store_pose(_chain, _frame);
+			break;
+		case IK_POSE_HALF:
+		case IK_POSE_QUANT: {
+			float* root = _frame;
+			root[0] = nodes[n - 1].pos.x;
+			root[1] = nodes[n - 1].pos.y;
+			root[2] = nodes[n - 1].pos.z;
+			
+			vec3f pos = {root[0], root[1], root[2]}; // where the decoder puts node k
+			for (int k = n - 1; k >= 0; k--) {
+				vec3f dir = k && nodes[k].length > 0 ? norm3f(sub3f(nodes[k - 1].pos, pos)) : nodes[k].rtn;
+				dir = __ik_pose_put_dir(_encoding, root + 3, k, dir);
+				if (k) pos = add3f(pos, mul3f(dir, nodes[k].length));
+			}
+			break;
+		}
+	}
+}
+
+/* restores the pose of `_chain` from `_frame`, which must have been stored
+ * from a chain with as many nodes (and for `IK_POSE_HALF` and `IK_POSE_QUANT`
+ * the same bone lengths). the next warm solve starts over. */
+void ik_pose_decode(struct ik_chain* _chain, int _encoding, const void* _frame) {
+	struct ik_node* nodes = _chain->nodes;
+	int n = _chain->num_nodes;
+	
+	switch (_encoding) {
+		case IK_POSE_NODES:
+			memcpy(nodes, (void*) _frame, n * sizeof(struct ik_node));
+			break;
+		case IK_POSE_REAL: {
+			const struct ik_node_pose* p = _frame;
+			for (int k = 0; k < n; k++) {
+				nodes[k].pos = p[k].pos;
+				nodes[k].rtn = p[k].rtn;
+			}
+			break;
+		}
+		case IK_POSE_HALF:
+		case IK_POSE_QUANT: {
+			const float* root = _frame;
+			nodes[n - 1].pos = (vec3f) {root[0], root[1], root[2]};
+			for (int k = n - 1; k >= 0; k--) {
+				nodes[k].rtn = __ik_pose_get_dir(_encoding, root + 3, k);
+				if (k) nodes[k - 1].pos = add3f(nodes[k].pos, mul3f(nodes[k].rtn, nodes[k].length));
+			}
+			break;
+		}
+	}
+	
+	ik_chain_invalidate(_chain);
+}
+
+/* internal function that maps an open pose file */
+int __ik_pose_file_map(struct ik_pose_file* _file, int _prot, int _flags) {
+	_file->map = mmap(0, _file->size, _prot, _flags, _file->fd, 0);
+	if (_file->map == MAP_FAILED) {
+		close(_file->fd);
+		return -1;
+	}
+	
+	_file->header = (struct ik_pose_header*) _file->map;
+	return 0;
+}
+
+/* creates (or truncates) the file at `_path` with room for `_num_frames`
+ * frames of `_num_nodes` nodes and maps it shared. (returns -1 on error or
+ * for an unknown encoding) */
+int ik_pose_file_create(struct ik_pose_file* _file, const char* _path, int _encoding, int _num_nodes, int _num_frames) {
+	if (_encoding < IK_POSE_NODES || _encoding > IK_POSE_QUANT) return -1;
+	
+	struct ik_pose_header header = {
+		IK_POSE_MAGIC, IK_POSE_VERSION, _encoding, sizeof(real), sizeof(struct ik_node),
+		_num_nodes, _num_frames, ik_pose_frame_size(_encoding, _num_nodes)
+	};
+	
+	_file->size = sizeof(header) + (size_t) _num_frames * header.frame_size;
+	_file->fd = open(_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (_file->fd == -1) return -1;
+	
+	if (ftruncate(_file->fd, _file->size) == -1) {
+		close(_file->fd);
+		return -1;
+	}
+	
+	if (__ik_pose_file_map(_file, PROT_READ | PROT_WRITE, MAP_SHARED) == -1) return -1;
+	
+	*_file->header = header;
+	return 0;
+}
+
+/* maps an existing pose file. with `_shared` 0 it is mapped copy-on-write,
+ * so views of it can be solved without changing the file. (returns -1 on
+ * error or if the file was written by an incompatible build) */
+int ik_pose_file_open(struct ik_pose_file* _file, const char* _path, int _shared) {
+	_file->fd = open(_path, _shared ? O_RDWR : O_RDONLY);
+	if (_file->fd == -1) return -1;
+	
+	off_t size = lseek(_file->fd, 0, SEEK_END);
+	if (size < (off_t) sizeof(struct ik_pose_header)) {
+		close(_file->fd);
+		return -1;
+	}
+	
+	_file->size = size;
+	if (__ik_pose_file_map(_file, PROT_READ | PROT_WRITE, _shared ? MAP_SHARED : MAP_PRIVATE) == -1) return -1;
+	
+	struct ik_pose_header* h = _file->header;
+	if (
+		memcmp(h->magic, IK_POSE_MAGIC, 4) || h->version != IK_POSE_VERSION || h->encoding > IK_POSE_QUANT ||
+		h->real_size != sizeof(real) || h->node_size != sizeof(struct ik_node) ||
+		h->frame_size != ik_pose_frame_size(h->encoding, h->num_nodes) ||
+		_file->size < sizeof(*h) + (size_t) h->num_frames * h->frame_size
+	) {
+		munmap(_file->map, _file->size);
+		close(_file->fd);
+		return -1;
+	}
+	
+	return 0;
+}
+
+void ik_pose_file_close(struct ik_pose_file* _file) {
+	munmap(_file->map, _file->size);
+	close(_file->fd);
+}
+
+/* start of frame `_frame` of a pose file */
+void* ik_pose_frame(struct ik_pose_file* _file, int _frame) {
+	return _file->map + sizeof(struct ik_pose_header) + (size_t) _frame * _file->header->frame_size;
+}
+
+/* internal function that checks that `_chain` and `_frame` fit a file */
+int __ik_pose_fits(struct ik_pose_file* _file, int _frame, struct ik_chain* _chain) {
+	return _chain->num_nodes == (int) _file->header->num_nodes && _frame >= 0 && _frame < (int) _file->header->num_frames;
+}
+
+/* stores the pose of `_chain` as frame `_frame` (returns -1 if the chain
+ * does not fit the file) */
+int ik_pose_file_store(struct ik_pose_file* _file, int _frame, struct ik_chain* _chain) {
+	if (!__ik_pose_fits(_file, _frame, _chain)) return -1;
+	
+	ik_pose_encode(_chain, _file->header->encoding, ik_pose_frame(_file, _frame));
+	return 0;
+}
+
+/* restores the pose of `_chain` from frame `_frame` */
+int ik_pose_file_load(struct ik_pose_file* _file, int _frame, struct ik_chain* _chain) {
+	if (!__ik_pose_fits(_file, _frame, _chain)) return -1;
+	
+	ik_pose_decode(_chain, _file->header->encoding, ik_pose_frame(_file, _frame));
+	return 0;
+}
+
+/* points the nodes of `_chain` at frame `_frame` of an `IK_POSE_NODES` file
+ * without copying, solving the chain then writes the frame (or its private
+ * copy). the chain's own node array is left alone, point `_chain->nodes` back
+ * at it when done with the view. */
+int ik_pose_view(struct ik_pose_file* _file, int _frame, struct ik_chain* _chain) {
+	if (_file->header->encoding != IK_POSE_NODES || !__ik_pose_fits(_file, _frame, _chain)) return -1;
+	
+	_chain->nodes = ik_pose_frame(_file, _frame);
+	ik_chain_invalidate(_chain);
+	return 0;
+}
+
+#endif
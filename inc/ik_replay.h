@@ -0,0 +1,60 @@
+#ifndef __INVERSE_KINEMATICS_REPLAY_H__
+#define __INVERSE_KINEMATICS_REPLAY_H__
+
+/* pose hashes for checking networked replays: peers exchange targets and
+ * compare hashes instead of sending whole poses. hashes only match between
+ * builds of the same precision that are both `IK_DETERMINISTIC`. */
+
+enum {IK_REPLAY_FABRIK, IK_REPLAY_CCD};
+
+#define IK_HASH_SEED 0xCBF29CE484222325ULL // FNV-1a offset basis
+
+/* internal function that folds the bytes of `_x` into a FNV-1a hash */
+uint64_t __ik_hash_real(uint64_t _hash, real _x) {
+	if (_x == 0) _x = 0; // -0 and 0 are the same pose
+	
+	unsigned char bytes[sizeof(real)];
+	memcpy(bytes, &_x, sizeof(real));
+	
+	for (int i = 0; i < (int) sizeof(real); i++) {
+		_hash ^= bytes[i];
+		_hash *= 0x100000001B3ULL; // FNV-1a prime
+	}
+	
+	return _hash;
+}
+
+/* folds the positions and directions of every node of a chain into `_hash`
+ * (start with `IK_HASH_SEED`) */
+uint64_t ik_chain_hash(struct ik_chain* _chain, uint64_t _hash) {
+	for (int i = 0; i < _chain->num_nodes; i++) {
+		struct ik_node* n = &_chain->nodes[i];
+		_hash = __ik_hash_real(_hash, n->pos.x);
+		_hash = __ik_hash_real(_hash, n->pos.y);
+		_hash = __ik_hash_real(_hash, n->pos.z);
+		_hash = __ik_hash_real(_hash, n->rtn.x);
+		_hash = __ik_hash_real(_hash, n->rtn.y);
+		_hash = __ik_hash_real(_hash, n->rtn.z);
+	}
+	
+	return _hash;
+}
+
+/* resets `_chain`, solves it towards each of `_targets` in turn (with
+ * `IK_REPLAY_FABRIK` or `IK_REPLAY_CCD`, `_rigidity` is for CCD only) and
+ * returns the hash of every pose along the way. `_opts` may be null for the
+ * solver's defaults. */
+uint64_t ik_chain_replay(struct ik_chain* _chain, vec3f* _targets, int _num_targets, int _solver, real _rigidity, struct ik_solve_opts* _opts) {
+	uint64_t hash = IK_HASH_SEED;
+	ik_reset_chain(_chain);
+	
+	for (int i = 0; i < _num_targets; i++) {
+		if (_solver == IK_REPLAY_CCD) ik_chain_solve_ccd(_chain, _targets[i], _rigidity, _opts, 0);
+		else ik_chain_solve_fabrik(_chain, _targets[i], _opts, 0);
+		hash = ik_chain_hash(_chain, hash);
+	}
+	
+	return hash;
+}
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef __INVERSE_KINEMATICS_SHM_H__
+#define __INVERSE_KINEMATICS_SHM_H__
+
+#include <time.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <linux/mman.h>
+
+/* IK as a service over POSIX shared memory. the server (ik_server.c) owns
+ * a chain and a segment holding a ring of `capacity` slots. a client writes
+ * a target into slot `head` and bumps `head`, the server solves it, writes
+ * the pose and outcome back into the same slot and bumps `done`. there is
+ * one producer and one consumer of each counter, so the ring needs no locks,
+ * and neither side makes a syscall while the other keeps up: waiting spins
+ * for `IK_SHM_SPIN` polls before it yields, then sleeps. */
+
+#define IK_SHM_MAGIC "IKSM"
+#define IK_SHM_VERSION 1
+#define IK_SHM_NAME "/ik"
+#define IK_SHM_SPIN 4096 // polls before yielding
+#define IK_SHM_IDLE_NS 100000 // sleep once yielding did not help either
+
+struct ik_shm_header {
+	char magic[4];
+	uint16_t version;
+	uint16_t real_size;
+	uint32_t num_nodes;
+	uint32_t capacity; // a power of two
+	uint32_t slot_size;
+	_Atomic int running; // cleared to stop the server
+	_Atomic uint64_t head __attribute__((aligned(64))); // requests submitted (client)
+	_Atomic uint64_t done __attribute__((aligned(64))); // requests solved (server)
+} __attribute__((aligned(64)));
+
+/* request `seq` lives in slot `seq & (capacity - 1)`, slots are padded to
+ * cache lines */
+struct ik_shm_slot {
+	vec3f target;
+	struct ik_solve_result res;
+	struct ik_node_pose pose[]; // `num_nodes` of them
+};
+
+/* one process's mapping of a segment */
+struct ik_shm {
+	int fd;
+	size_t size;
+	struct ik_shm_header* header;
+	char* slots;
+	uint64_t tail; // requests whose result the client has consumed
+};
+
+static inline void __ik_shm_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#else
+	atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+/* internal function that waits until `*_counter` passes `_seq` (returns -1 if
+ * the server stopped in the meantime) */
+int __ik_shm_wait(struct ik_shm* _shm, _Atomic uint64_t* _counter, uint64_t _seq) {
+	for (long polls = 0; atomic_load_explicit(_counter, memory_order_acquire) <= _seq; polls++) {
+		if (!atomic_load_explicit(&_shm->header->running, memory_order_relaxed)) return -1;
+		
+		if (polls < IK_SHM_SPIN) __ik_shm_relax();
+		else if (polls < 2 * IK_SHM_SPIN) sched_yield();
+		else nanosleep(&(struct timespec) {0, IK_SHM_IDLE_NS}, 0);
+	}
+	
+	return 0;
+}
+
+/* slot of request `_seq` */
+struct ik_shm_slot* ik_shm_slot(struct ik_shm* _shm, uint64_t _seq) {
+	return (struct ik_shm_slot*) (_shm->slots + (_seq & (_shm->header->capacity - 1)) * _shm->header->slot_size);
+}
+
+/* internal function that maps an open segment */
+int __ik_shm_map(struct ik_shm* _shm) {
+	char* map = mmap(0, _shm->size, PROT_READ | PROT_WRITE, MAP_SHARED, _shm->fd, 0);
+	if (map == MAP_FAILED) {
+		close(_shm->fd);
+		return -1;
+	}
+	
+	_shm->header = (struct ik_shm_header*) map;
+	_shm->slots = map + sizeof(struct ik_shm_header);
+	_shm->tail = 0;
+	return 0;
+}
+
+/* creates the segment `_name` (server side) for a chain of `_num_nodes`
+ * nodes, with `_capacity` (a power of two) requests in flight at most.
+ * (returns -1 on error) */
+int ik_shm_create(struct ik_shm* _shm, const char* _name, int _num_nodes, int _capacity) {
+	size_t slot_size = sizeof(struct ik_shm_slot) + _num_nodes * sizeof(struct ik_node_pose);
+	slot_size = (slot_size + 63) & ~(size_t) 63;
+	
+	if (_capacity <= 0 || _capacity & (_capacity - 1)) return -1;
+	
+	_shm->size = sizeof(struct ik_shm_header) + _capacity * slot_size;
+	_shm->fd = shm_open(_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (_shm->fd == -1) return -1;
+	
+	if (ftruncate(_shm->fd, _shm->size) == -1) {
+		close(_shm->fd);
+		return -1;
+	}
+	
+	if (__ik_shm_map(_shm) == -1) return -1;
+	
+	struct ik_shm_header* h = _shm->header;
+	memcpy(h->magic, IK_SHM_MAGIC, 4);
+	h->version = IK_SHM_VERSION;
+	h->real_size = sizeof(real);
+	h->num_nodes = _num_nodes;
+	h->capacity = _capacity;
+	h->slot_size = slot_size;
+	atomic_store(&h->head, 0);
+	atomic_store(&h->done, 0);
+	atomic_store_explicit(&h->running, 1, memory_order_release);
+	return 0;
+}
+
+/* maps the segment `_name` of a running server (client side). (returns -1
+ * on error, if the server was built with another precision or if the header
+ * does not describe a ring that fits the segment) */
+int ik_shm_open(struct ik_shm* _shm, const char* _name) {
+	_shm->fd = shm_open(_name, O_RDWR, 0);
+	if (_shm->fd == -1) return -1;
+	
+	off_t size = lseek(_shm->fd, 0, SEEK_END);
+	if (size < (off_t) sizeof(struct ik_shm_header)) {
+		close(_shm->fd);
+		return -1;
+	}
+	
+	_shm->size = size;
+	if (__ik_shm_map(_shm) == -1) return -1;
+	
+	struct ik_shm_header* h = _shm->header;
+	if (
+		memcmp(h->magic, IK_SHM_MAGIC, 4) || h->version != IK_SHM_VERSION || h->real_size != sizeof(real) ||
+		!h->capacity || h->capacity & (h->capacity - 1) ||
+		h->slot_size < sizeof(struct ik_shm_slot) + (size_t) h->num_nodes * sizeof(struct ik_node_pose) ||
+		_shm->size < sizeof(*h) + (size_t) h->capacity * h->slot_size
+	) {
+		munmap(_shm->header, _shm->size);
+		close(_shm->fd);
+		return -1;
+	}
+	
+	// pick up where a previous client left off
+	_shm->tail = atomic_load_explicit(&h->head, memory_order_acquire);
+	return 0;
+}
+
+void ik_shm_close(struct ik_shm* _shm) {
+	munmap(_shm->header, _shm->size);
+	close(_shm->fd);
+}
+
+/* asks the server to stop (it finishes the request it is solving) */
+void ik_shm_stop(struct ik_shm* _shm) {
+	atomic_store_explicit(&_shm->header->running, 0, memory_order_release);
+}
+
+/* solves requests into `_chain` (of the segment's `num_nodes` nodes) as they
+ * come in, until `ik_shm_stop`. each request is solved warm from the pose of
+ * the last one. (returns the number of requests solved) */
+uint64_t ik_shm_serve(struct ik_shm* _shm, struct ik_chain* _chain, struct ik_warm_opts* _opts) {
+	struct ik_shm_header* h = _shm->header;
+	uint64_t seq = atomic_load_explicit(&h->done, memory_order_relaxed), first = seq;
+	
+	while (__ik_shm_wait(_shm, &h->head, seq) == 0) {
+		struct ik_shm_slot* slot = ik_shm_slot(_shm, seq);
+		
+		ik_chain_solve_fabrik_warm(_chain, slot->target, _opts, &slot->res);
+		__ik_store_pose(_chain, slot->pose);
+		atomic_store_explicit(&h->done, ++seq, memory_order_release);
+	}
+	
+	return seq - first;
+}
+
+/* queues a solve towards `_target` (client side). (returns -1 if every slot
+ * holds a request or result not yet consumed with `ik_shm_release`) */
+int ik_shm_submit(struct ik_shm* _shm, vec3f _target) {
+	struct ik_shm_header* h = _shm->header;
+	uint64_t head = atomic_load_explicit(&h->head, memory_order_relaxed);
+	if (head - _shm->tail >= h->capacity) return -1;
+	
+	ik_shm_slot(_shm, head)->target = _target;
+	atomic_store_explicit(&h->head, head + 1, memory_order_release);
+	return 0;
+}
+
+/* waits for the oldest unconsumed request and returns its slot, which stays
+ * valid until `ik_shm_release`. (returns null if nothing is queued or the
+ * server stopped) */
+struct ik_shm_slot* ik_shm_result(struct ik_shm* _shm) {
+	if (_shm->tail == atomic_load_explicit(&_shm->header->head, memory_order_relaxed)) return 0;
+	if (__ik_shm_wait(_shm, &_shm->header->done, _shm->tail) == -1) return 0;
+	return ik_shm_slot(_shm, _shm->tail);
+}
+
+/* hands the slot of the oldest result back to the ring */
+void ik_shm_release(struct ik_shm* _shm) {
+	_shm->tail++;
+}
+
+/* solves towards `_target` and copies the pose into `_poses` (room for
+ * `num_nodes`, may be null) and the outcome into `_res` (may be null), for
+ * clients with one request in flight. (returns -1 if the server stopped) */
+int ik_shm_solve(struct ik_shm* _shm, vec3f _target, struct ik_node_pose* _poses, struct ik_solve_result* _res) {
+	if (ik_shm_submit(_shm, _target) == -1) return -1;
+	
+	struct ik_shm_slot* slot = ik_shm_result(_shm);
+	if (!slot) return -1;
+	
+	if (_poses) memcpy(_poses, slot->pose, _shm->header->num_nodes * sizeof(struct ik_node_pose));
+	if (_res) *_res = slot->res;
+	ik_shm_release(_shm);
+	return 0;
+}
+
+#endif
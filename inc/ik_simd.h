@@ -0,0 +1,369 @@
+#ifndef __INVERSE_KINEMATICS_SIMD_H__
+#define __INVERSE_KINEMATICS_SIMD_H__
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define IK_SIMD_X86
+#endif
+
+#ifdef LINALG_FLOAT
+	#define IK_SIMD_MAX_WIDTH 8
+#else
+	#define IK_SIMD_MAX_WIDTH 4
+#endif
+
+/* a pack holds several chains with the same number of nodes, lane
+ * interleaved (value of node k in lane l at index `k * width + l`), so one
+ * vector load fetches the same node of every chain. only circular limits are
+ * supported (see `__ik_chain_has_ellipse`). */
+struct ik_pack {
+	short num_nodes; // nodes per chain
+	short capacity; // largest `num_nodes` the arrays can hold
+	int width; // number of chains (lanes)
+	real* px, *py, *pz; // node positions
+	real* rx, *ry, *rz; // node directions
+	real* lengths;
+	real* cos_ap, *sin_ap; // cosine and sine of node apertures
+	real chain_rx[IK_SIMD_MAX_WIDTH], chain_ry[IK_SIMD_MAX_WIDTH], chain_rz[IK_SIMD_MAX_WIDTH];
+	real chain_cos_ap[IK_SIMD_MAX_WIDTH], chain_sin_ap[IK_SIMD_MAX_WIDTH];
+};
+
+/* internal function that tells if any joint of a chain has an elliptical
+ * limit */
+int __ik_chain_has_ellipse(struct ik_chain* _chain) {
+	if (_chain->limit.type == IK_LIMIT_ELLIPSE) return 1;
+	for (int k = 0; k < _chain->num_nodes; k++)
+		if (_chain->limits[k].type == IK_LIMIT_ELLIPSE) return 1;
+	return 0;
+}
+
+/* allocates a pack able to hold `IK_SIMD_MAX_WIDTH` chains of up to
+ * `_capacity` nodes. (returns -1 on error) */
+int ik_pack_alloc(struct ik_pack* _pack, short _capacity) {
+	int n = _capacity * IK_SIMD_MAX_WIDTH;
+	real* block = malloc(9 * n * sizeof(real));
+	if (!block) return -1;
+	
+	_pack->num_nodes = 0;
+	_pack->capacity = _capacity;
+	_pack->width = 0;
+	_pack->px = block + 0 * n;
+	_pack->py = block + 1 * n;
+	_pack->pz = block + 2 * n;
+	_pack->rx = block + 3 * n;
+	_pack->ry = block + 4 * n;
+	_pack->rz = block + 5 * n;
+	_pack->lengths = block + 6 * n;
+	_pack->cos_ap = block + 7 * n;
+	_pack->sin_ap = block + 8 * n;
+	
+	return 0;
+}
+
+void ik_pack_free(struct ik_pack* _pack) {
+	free(_pack->px);
+	_pack->px = 0;
+	_pack->capacity = _pack->num_nodes = 0;
+}
+
+/* interleaves `_width` chains (all with the same number of nodes, which must
+ * fit in the pack) into the lanes of `_pack`. */
+void ik_pack_load(struct ik_pack* _pack, struct ik_chain* _chains, int _width) {
+	int w = _pack->width = _width;
+	_pack->num_nodes = _chains[0].num_nodes;
+	
+	for (int l = 0; l < w; l++) {
+		struct ik_chain* c = &_chains[l];
+		
+		_pack->chain_rx[l] = c->rtn.x;
+		_pack->chain_ry[l] = c->rtn.y;
+		_pack->chain_rz[l] = c->rtn.z;
+		_pack->chain_cos_ap[l] = c->limit.cos_ap;
+		_pack->chain_sin_ap[l] = c->limit.sin_ap;
+		
+		for (int k = 0; k < c->num_nodes; k++) {
+			struct ik_node* n = &c->nodes[k];
+			_pack->px[k * w + l] = n->pos.x;
+			_pack->py[k * w + l] = n->pos.y;
+			_pack->pz[k * w + l] = n->pos.z;
+			_pack->rx[k * w + l] = n->rtn.x;
+			_pack->ry[k * w + l] = n->rtn.y;
+			_pack->rz[k * w + l] = n->rtn.z;
+			_pack->lengths[k * w + l] = n->length;
+			_pack->cos_ap[k * w + l] = c->limits[k].cos_ap;
+			_pack->sin_ap[k * w + l] = c->limits[k].sin_ap;
+		}
+	}
+}
+
+/* writes the positions and directions held in the lanes of `_pack` back into
+ * the chains they were loaded from. */
+void ik_pack_store(struct ik_pack* _pack, struct ik_chain* _chains) {
+	int w = _pack->width;
+	
+	for (int l = 0; l < w; l++) {
+		struct ik_chain* c = &_chains[l];
+		
+		for (int k = 0; k < c->num_nodes; k++) {
+			struct ik_node* n = &c->nodes[k];
+			n->pos = (vec3f) {_pack->px[k * w + l], _pack->py[k * w + l], _pack->pz[k * w + l]};
+			n->rtn = (vec3f) {_pack->rx[k * w + l], _pack->ry[k * w + l], _pack->rz[k * w + l]};
+		}
+	}
+}
+
+#ifdef IK_SIMD_X86
+	// AVX2, four chains per pack (eight in single precision)
+	#define VI __m256i
+	#ifdef LINALG_FLOAT
+		#define V __m256
+		#define V_W 8
+		#define V_LD _mm256_loadu_ps
+		#define V_ST _mm256_storeu_ps
+		#define V_SET1 _mm256_set1_ps
+		#define V_SET1I _mm256_set1_epi32
+		#define V_ADD _mm256_add_ps
+		#define V_SUB _mm256_sub_ps
+		#define V_MUL _mm256_mul_ps
+		#define V_DIV _mm256_div_ps
+		#define V_SQRT _mm256_sqrt_ps
+		#define V_LT(A, B) _mm256_cmp_ps(A, B, _CMP_LT_OQ)
+		#define V_SEL(A, B, M) _mm256_blendv_ps(A, B, M)
+		#define V_AS_I _mm256_castps_si256
+		#define I_AS_V _mm256_castsi256_ps
+		#define V_SRLI _mm256_srli_epi32
+		#define V_SUBI _mm256_sub_epi32
+	#else
+		#define V __m256d
+		#define V_W 4
+		#define V_LD _mm256_loadu_pd
+		#define V_ST _mm256_storeu_pd
+		#define V_SET1 _mm256_set1_pd
+		#define V_SET1I _mm256_set1_epi64x
+		#define V_ADD _mm256_add_pd
+		#define V_SUB _mm256_sub_pd
+		#define V_MUL _mm256_mul_pd
+		#define V_DIV _mm256_div_pd
+		#define V_SQRT _mm256_sqrt_pd
+		#define V_LT(A, B) _mm256_cmp_pd(A, B, _CMP_LT_OQ)
+		#define V_SEL(A, B, M) _mm256_blendv_pd(A, B, M)
+		#define V_AS_I _mm256_castpd_si256
+		#define I_AS_V _mm256_castsi256_pd
+		#define V_SRLI _mm256_srli_epi64
+		#define V_SUBI _mm256_sub_epi64
+	#endif
+	#define IK_SIMD_TARGET __attribute__((target("avx2")))
+	#define IK_SIMD_FN(N) N##_avx2
+	#include "ik_simd_kernel.h"
+	#undef V
+	#undef VI
+	#undef V_W
+	#undef V_LD
+	#undef V_ST
+	#undef V_SET1
+	#undef V_SET1I
+	#undef V_ADD
+	#undef V_SUB
+	#undef V_MUL
+	#undef V_DIV
+	#undef V_SQRT
+	#undef V_LT
+	#undef V_SEL
+	#undef V_AS_I
+	#undef I_AS_V
+	#undef V_SRLI
+	#undef V_SUBI
+	#undef IK_SIMD_TARGET
+	#undef IK_SIMD_FN
+	
+	// SSE2, two chains per pack, four in single precision (SSE2 has no
+	// blend, so select with masks)
+	#define VI __m128i
+	#ifdef LINALG_FLOAT
+		#define V __m128
+		#define V_W 4
+		#define V_LD _mm_loadu_ps
+		#define V_ST _mm_storeu_ps
+		#define V_SET1 _mm_set1_ps
+		#define V_SET1I _mm_set1_epi32
+		#define V_ADD _mm_add_ps
+		#define V_SUB _mm_sub_ps
+		#define V_MUL _mm_mul_ps
+		#define V_DIV _mm_div_ps
+		#define V_SQRT _mm_sqrt_ps
+		#define V_LT _mm_cmplt_ps
+		#define V_SEL(A, B, M) _mm_or_ps(_mm_and_ps(M, B), _mm_andnot_ps(M, A))
+		#define V_AS_I _mm_castps_si128
+		#define I_AS_V _mm_castsi128_ps
+		#define V_SRLI _mm_srli_epi32
+		#define V_SUBI _mm_sub_epi32
+	#else
+		#define V __m128d
+		#define V_W 2
+		#define V_LD _mm_loadu_pd
+		#define V_ST _mm_storeu_pd
+		#define V_SET1 _mm_set1_pd
+		#define V_SET1I _mm_set1_epi64x
+		#define V_ADD _mm_add_pd
+		#define V_SUB _mm_sub_pd
+		#define V_MUL _mm_mul_pd
+		#define V_DIV _mm_div_pd
+		#define V_SQRT _mm_sqrt_pd
+		#define V_LT _mm_cmplt_pd
+		#define V_SEL(A, B, M) _mm_or_pd(_mm_and_pd(M, B), _mm_andnot_pd(M, A))
+		#define V_AS_I _mm_castpd_si128
+		#define I_AS_V _mm_castsi128_pd
+		#define V_SRLI _mm_srli_epi64
+		#define V_SUBI _mm_sub_epi64
+	#endif
+	#define IK_SIMD_TARGET __attribute__((target("sse2")))
+	#define IK_SIMD_FN(N) N##_sse2
+	#include "ik_simd_kernel.h"
+	#undef V
+	#undef VI
+	#undef V_W
+	#undef V_LD
+	#undef V_ST
+	#undef V_SET1
+	#undef V_SET1I
+	#undef V_ADD
+	#undef V_SUB
+	#undef V_MUL
+	#undef V_DIV
+	#undef V_SQRT
+	#undef V_LT
+	#undef V_SEL
+	#undef V_AS_I
+	#undef I_AS_V
+	#undef V_SRLI
+	#undef V_SUBI
+	#undef IK_SIMD_TARGET
+	#undef IK_SIMD_FN
+#endif
+
+/* returns the number of chains solved in lockstep on this machine (4 with
+ * AVX2, 2 with SSE2, twice that in single precision, 1 if there is no vector
+ * path or the build is deterministic, so poses never depend on the vector
+ * width). */
+int ik_simd_width(void) {
+	static int width = 0;
+	if (width) return width;
+	
+	width = 1;
+	#if defined(IK_SIMD_X86) && !defined(LINALG_DETERMINISTIC)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) width = IK_SIMD_MAX_WIDTH;
+		else if (__builtin_cpu_supports("sse2")) width = IK_SIMD_MAX_WIDTH / 2;
+	#endif
+	
+	return width;
+}
+
+static inline vec3f __ik_pack_vec(real* _x, real* _y, real* _z, int _i) {
+	return (vec3f) {_x[_i], _y[_i], _z[_i]};
+}
+
+static inline void __ik_pack_set_vec(real* _x, real* _y, real* _z, int _i, vec3f _v) {
+	_x[_i] = _v.x;
+	_y[_i] = _v.y;
+	_z[_i] = _v.z;
+}
+
+/* internal function that solves the lanes of a pack one after the other, for
+ * widths without a vector path (mirrors `ik_chain_solve_fabrik`) */
+void __ik_pack_solve_fabrik_scalar(struct ik_pack* _p, vec3f* _targets, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	int w = _p->width, last = _p->num_nodes - 1;
+	
+	#define P(K) __ik_pack_vec(_p->px, _p->py, _p->pz, (K) * w + l)
+	#define R(K) __ik_pack_vec(_p->rx, _p->ry, _p->rz, (K) * w + l)
+	#define SET_P(K, VAL) __ik_pack_set_vec(_p->px, _p->py, _p->pz, (K) * w + l, VAL)
+	#define SET_R(K, VAL) __ik_pack_set_vec(_p->rx, _p->ry, _p->rz, (K) * w + l, VAL)
+	#define LEN(K) _p->lengths[(K) * w + l]
+	#define COS(K) _p->cos_ap[(K) * w + l]
+	#define SIN(K) _p->sin_ap[(K) * w + l]
+	
+	for (int l = 0; l < w; l++) {
+		vec3f target; // current target position
+		vec3f joint_vec; // vector from joint to current target
+		vec3f root = P(last);
+		vec3f chain_rtn = {_p->chain_rx[l], _p->chain_ry[l], _p->chain_rz[l]};
+		real error = mag3f(sub3f(P(0), _targets[l]));
+		int i;
+		
+		for (i = 0; i < _opts->max_iterations && error > _opts->tolerance; ) {
+			// forward pass
+			target = _targets[l];
+			SET_P(0, target);
+			
+			joint_vec = norm3f(sub3f(target, P(1)));
+			target = sub3f(target, mul3f(joint_vec, LEN(1)));
+			SET_P(1, target);
+			SET_R(1, joint_vec);
+			
+			for (int k = 1; k < last - 1; k++) {
+				joint_vec = norm3f(sub3f(target, P(k + 1)));
+				joint_vec = __ik_clamp_vector_to_cone(R(k), COS(k), SIN(k), joint_vec);
+				
+				target = sub3f(target, mul3f(joint_vec, LEN(k + 1)));
+				SET_P(k + 1, target);
+				SET_R(k + 1, joint_vec);
+			}
+			
+			// backward pass
+			target = root;
+			SET_P(last, target);
+			
+			joint_vec = norm3f(sub3f(P(last - 1), target));
+			joint_vec = __ik_clamp_vector_to_cone(chain_rtn, _p->chain_cos_ap[l], _p->chain_sin_ap[l], joint_vec);
+			target = add3f(target, mul3f(joint_vec, LEN(last)));
+			SET_P(last - 1, target);
+			SET_R(last, joint_vec);
+			
+			for (int k = last - 1; k > 0; k--) {
+				joint_vec = norm3f(sub3f(P(k - 1), target));
+				joint_vec = __ik_clamp_vector_to_cone(R(k + 1), COS(k + 1), SIN(k + 1), joint_vec);
+				
+				target = add3f(target, mul3f(joint_vec, LEN(k)));
+				SET_P(k - 1, target);
+				SET_R(k, joint_vec);
+			}
+			
+			// set effector rotation
+			SET_R(0, R(1));
+			
+			i++;
+			real last_error = error;
+			error = mag3f(sub3f(P(0), _targets[l]));
+			if (last_error - error < _opts->min_improvement) break;
+		}
+		
+		if (_res) _res[l] = (struct ik_solve_result) {i, error};
+	}
+	
+	#undef P
+	#undef R
+	#undef SET_P
+	#undef SET_R
+	#undef LEN
+	#undef COS
+	#undef SIN
+}
+
+/* solves every lane of a loaded pack with FABRIK, lane i towards
+ * `_targets[i]` (stored into `_results[i]` if given, `_opts` may be null for
+ * the defaults). packs as wide as `ik_simd_width()` are solved in lockstep,
+ * any other width one lane at a time. */
+void ik_pack_solve_fabrik(struct ik_pack* _pack, vec3f* _targets, struct ik_solve_opts* _opts, struct ik_solve_result* _results) {
+	struct ik_solve_opts opts = _opts ? *_opts : IK_FABRIK_DEFAULTS;
+	
+	#ifdef IK_SIMD_X86
+		switch (_pack->width) {
+			case IK_SIMD_MAX_WIDTH: __ik_pack_solve_fabrik_avx2(_pack, _targets, &opts, _results); return;
+			case IK_SIMD_MAX_WIDTH / 2: __ik_pack_solve_fabrik_sse2(_pack, _targets, &opts, _results); return;
+		}
+	#endif
+	
+	__ik_pack_solve_fabrik_scalar(_pack, _targets, &opts, _results);
+}
+
+#endif
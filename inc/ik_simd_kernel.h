@@ -0,0 +1,219 @@
+/* lockstep FABRIK kernel, instantiated once per instruction set by
+ * inc/ik_simd.h. the includer defines:
+ *  V, VI           - vector of reals / vector of integers as wide as a real
+ *  V_W             - number of lanes
+ *  V_LD, V_ST      - unaligned load / store
+ *  V_SET1, V_SET1I - broadcast a real / integer
+ *  V_ADD, V_SUB, V_MUL, V_DIV, V_SQRT
+ *  V_LT            - lane mask of a < b
+ *  V_SEL           - V_SEL(a, b, m) picks b where m is set, a elsewhere
+ *  V_AS_I, I_AS_V  - bit casts between V and VI
+ *  V_SRLI, V_SUBI  - integer logical right shift / subtraction
+ *  IK_SIMD_TARGET  - function attribute enabling the instruction set
+ *  IK_SIMD_FN(N)   - name mangling for this instantiation
+ * no include guard on purpose. */
+
+#define V3 IK_SIMD_FN(__ik_vec3v)
+
+typedef struct { V x, y, z; } V3;
+
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_load)(real* _x, real* _y, real* _z, int _k) {
+	return (V3) {V_LD(_x + _k * V_W), V_LD(_y + _k * V_W), V_LD(_z + _k * V_W)};
+}
+
+static inline IK_SIMD_TARGET void IK_SIMD_FN(__ik_v3_store)(real* _x, real* _y, real* _z, int _k, V3 _v) {
+	V_ST(_x + _k * V_W, _v.x);
+	V_ST(_y + _k * V_W, _v.y);
+	V_ST(_z + _k * V_W, _v.z);
+}
+
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_add)(V3 _a, V3 _b) {
+	return (V3) {V_ADD(_a.x, _b.x), V_ADD(_a.y, _b.y), V_ADD(_a.z, _b.z)};
+}
+
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_sub)(V3 _a, V3 _b) {
+	return (V3) {V_SUB(_a.x, _b.x), V_SUB(_a.y, _b.y), V_SUB(_a.z, _b.z)};
+}
+
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_mul)(V3 _v, V _c) {
+	return (V3) {V_MUL(_v.x, _c), V_MUL(_v.y, _c), V_MUL(_v.z, _c)};
+}
+
+static inline IK_SIMD_TARGET V IK_SIMD_FN(__ik_v3_dot)(V3 _a, V3 _b) {
+	return V_ADD(V_ADD(V_MUL(_a.x, _b.x), V_MUL(_a.y, _b.y)), V_MUL(_a.z, _b.z));
+}
+
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_cross)(V3 _a, V3 _b) {
+	return (V3) {
+		V_SUB(V_MUL(_a.y, _b.z), V_MUL(_a.z, _b.y)),
+		V_SUB(V_MUL(_a.z, _b.x), V_MUL(_a.x, _b.z)),
+		V_SUB(V_MUL(_a.x, _b.y), V_MUL(_a.y, _b.x)),
+	};
+}
+
+/* picks `_b` in the lanes set in `_m`, `_a` elsewhere */
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_sel)(V3 _a, V3 _b, V _m) {
+	return (V3) {V_SEL(_a.x, _b.x, _m), V_SEL(_a.y, _b.y, _m), V_SEL(_a.z, _b.z, _m)};
+}
+
+/* lane-wise `RSQRT` (same math tier, initial guess and newton steps, so the
+ * same bits) */
+static inline IK_SIMD_TARGET V IK_SIMD_FN(__ik_v_rsqrt)(V _x) {
+	#if LINALG_MATH_TIER == LINALG_EXACT
+		return V_DIV(V_SET1(1), V_SQRT(_x));
+	#else
+		V u = I_AS_V(V_SUBI(V_SET1I(REAL_ISQRT_MAGIC), V_SRLI(V_AS_I(_x), 1)));
+		V half_x = V_MUL(V_SET1(0.5), _x);
+		u = V_MUL(u, V_SUB(V_SET1(1.5), V_MUL(V_MUL(half_x, u), u)));
+		#if LINALG_MATH_TIER != LINALG_FASTEST
+			u = V_MUL(u, V_SUB(V_SET1(1.5), V_MUL(V_MUL(half_x, u), u)));
+		#endif
+		return u;
+	#endif
+}
+
+/* lane-wise `norm3f` */
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_norm)(V3 _v) {
+	return IK_SIMD_FN(__ik_v3_mul)(_v, IK_SIMD_FN(__ik_v_rsqrt)(IK_SIMD_FN(__ik_v3_dot)(_v, _v)));
+}
+
+/* lane-wise `__ik_swing_dir`, with the same fallback for lanes where `_v`
+ * is (anti)parallel to `_axis` */
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_swing_dir)(V3 _axis, V3 _v) {
+	V3 perp = IK_SIMD_FN(__ik_v3_cross)(IK_SIMD_FN(__ik_v3_cross)(_axis, _v), _axis);
+	V usable = V_LT(V_SET1(0.000000000001), IK_SIMD_FN(__ik_v3_dot)(perp, perp));
+	
+	// x unless the axis is close to it, then y
+	V abs_x = V_SEL(_axis.x, V_MUL(_axis.x, V_SET1(-1)), V_LT(_axis.x, V_SET1(0)));
+	V use_x = V_LT(abs_x, V_SET1(0.9));
+	V3 other = {V_SEL(V_SET1(0), V_SET1(1), use_x), V_SEL(V_SET1(1), V_SET1(0), use_x), V_SET1(0)};
+	V3 fallback = IK_SIMD_FN(__ik_v3_cross)(_axis, other);
+	
+	return IK_SIMD_FN(__ik_v3_norm)(IK_SIMD_FN(__ik_v3_sel)(fallback, perp, usable));
+}
+
+/* lane-wise `__ik_clamp_vector_to_cone`. comparing cosines replaces the
+ * acos, and since the rotation axis n is orthogonal to the cone's axis the
+ * quaternion rotation reduces to `axis * cos(a) + (n x axis) * sin(a)`. */
+static inline IK_SIMD_TARGET V3 IK_SIMD_FN(__ik_v3_clamp_to_cone)(V3 _axis, V _cos_ap, V _sin_ap, V3 _v) {
+	V cos_phi = IK_SIMD_FN(__ik_v3_dot)(_axis, _v);
+	V mask = V_LT(cos_phi, _cos_ap);
+	
+	V3 perp = IK_SIMD_FN(__ik_v3_swing_dir)(_axis, _v);
+	V3 edge = IK_SIMD_FN(__ik_v3_add)(
+		IK_SIMD_FN(__ik_v3_mul)(_axis, _cos_ap),
+		IK_SIMD_FN(__ik_v3_mul)(perp, _sin_ap)
+	);
+	
+	return IK_SIMD_FN(__ik_v3_sel)(_v, edge, mask);
+}
+
+/* solves the `V_W` chains of `_pack` with FABRIK, lane i of the pack towards
+ * `_targets[i]` (mirrors `ik_chain_solve_fabrik`). a lane that has converged
+ * or stopped improving is frozen: the pack keeps iterating for the others,
+ * but its pose is no longer written and its iterations no longer counted. */
+static IK_SIMD_TARGET void IK_SIMD_FN(__ik_pack_solve_fabrik)(struct ik_pack* _p, vec3f* _targets, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	#define P(K) IK_SIMD_FN(__ik_v3_load)(_p->px, _p->py, _p->pz, K)
+	#define R(K) IK_SIMD_FN(__ik_v3_load)(_p->rx, _p->ry, _p->rz, K)
+	#define SET_P(K, VAL) IK_SIMD_FN(__ik_v3_store)(_p->px, _p->py, _p->pz, K, IK_SIMD_FN(__ik_v3_sel)(P(K), VAL, live))
+	#define SET_R(K, VAL) IK_SIMD_FN(__ik_v3_store)(_p->rx, _p->ry, _p->rz, K, IK_SIMD_FN(__ik_v3_sel)(R(K), VAL, live))
+	#define LEN(K) V_LD(_p->lengths + (K) * V_W)
+	#define COS(K) V_LD(_p->cos_ap + (K) * V_W)
+	#define SIN(K) V_LD(_p->sin_ap + (K) * V_W)
+	
+	real tx[V_W], ty[V_W], tz[V_W];
+	for (int l = 0; l < V_W; l++)
+		tx[l] = _targets[l].x, ty[l] = _targets[l].y, tz[l] = _targets[l].z;
+	
+	int last = _p->num_nodes - 1;
+	V3 target; // current target position of every lane
+	V3 joint_vec; // vector from joint to current target
+	V3 root = P(last);
+	V3 chain_rtn = {V_LD(_p->chain_rx), V_LD(_p->chain_ry), V_LD(_p->chain_rz)};
+	
+	real error[V_W], last_error[V_W];
+	real running[V_W]; // 1 for the lanes still iterating
+	int iterations[V_W] = {0};
+	int i = 0, done = 1;
+	
+	for (int l = 0; l < V_W; l++) {
+		error[l] = mag3f(sub3f((vec3f) {_p->px[l], _p->py[l], _p->pz[l]}, _targets[l]));
+		running[l] = error[l] > _opts->tolerance;
+		if (running[l]) done = 0;
+	}
+	
+	while (!done && i < _opts->max_iterations) {
+		V live = V_LT(V_SET1(0), V_LD(running)); // lane mask of `running`
+		
+		///////////////////////////////////////////
+		// FORWARD PASS                          //
+		///////////////////////////////////////////
+		target = (V3) {V_LD(tx), V_LD(ty), V_LD(tz)};
+		SET_P(0, target);
+		
+		joint_vec = IK_SIMD_FN(__ik_v3_norm)(IK_SIMD_FN(__ik_v3_sub)(target, P(1)));
+		target = IK_SIMD_FN(__ik_v3_sub)(target, IK_SIMD_FN(__ik_v3_mul)(joint_vec, LEN(1)));
+		SET_P(1, target);
+		SET_R(1, joint_vec);
+		
+		for (int k = 1; k < last - 1; k++) {
+			joint_vec = IK_SIMD_FN(__ik_v3_norm)(IK_SIMD_FN(__ik_v3_sub)(target, P(k + 1)));
+			joint_vec = IK_SIMD_FN(__ik_v3_clamp_to_cone)(R(k), COS(k), SIN(k), joint_vec);
+			
+			target = IK_SIMD_FN(__ik_v3_sub)(target, IK_SIMD_FN(__ik_v3_mul)(joint_vec, LEN(k + 1)));
+			SET_P(k + 1, target);
+			SET_R(k + 1, joint_vec);
+		}
+		
+		///////////////////////////////////////////
+		// BACKWARD PASS                         //
+		///////////////////////////////////////////
+		target = root;
+		SET_P(last, target);
+		
+		joint_vec = IK_SIMD_FN(__ik_v3_norm)(IK_SIMD_FN(__ik_v3_sub)(P(last - 1), target));
+		joint_vec = IK_SIMD_FN(__ik_v3_clamp_to_cone)(chain_rtn, V_LD(_p->chain_cos_ap), V_LD(_p->chain_sin_ap), joint_vec);
+		target = IK_SIMD_FN(__ik_v3_add)(target, IK_SIMD_FN(__ik_v3_mul)(joint_vec, LEN(last)));
+		SET_P(last - 1, target);
+		SET_R(last, joint_vec);
+		
+		for (int k = last - 1; k > 0; k--) {
+			joint_vec = IK_SIMD_FN(__ik_v3_norm)(IK_SIMD_FN(__ik_v3_sub)(P(k - 1), target));
+			joint_vec = IK_SIMD_FN(__ik_v3_clamp_to_cone)(R(k + 1), COS(k + 1), SIN(k + 1), joint_vec);
+			
+			target = IK_SIMD_FN(__ik_v3_add)(target, IK_SIMD_FN(__ik_v3_mul)(joint_vec, LEN(k)));
+			SET_P(k - 1, target);
+			SET_R(k, joint_vec);
+		}
+		
+		// set effector rotation
+		SET_R(0, R(1));
+		
+		// freeze the lanes that are solved or no longer improving, stop once
+		// all of them are
+		i++;
+		done = 1;
+		for (int l = 0; l < V_W; l++) {
+			if (!running[l]) continue;
+			
+			iterations[l]++;
+			last_error[l] = error[l];
+			error[l] = mag3f(sub3f((vec3f) {_p->px[l], _p->py[l], _p->pz[l]}, _targets[l]));
+			running[l] = error[l] > _opts->tolerance && last_error[l] - error[l] >= _opts->min_improvement;
+			if (running[l]) done = 0;
+		}
+	}
+	
+	if (_res) for (int l = 0; l < V_W; l++)
+		_res[l] = (struct ik_solve_result) {iterations[l], error[l]};
+	
+	#undef P
+	#undef R
+	#undef SET_P
+	#undef SET_R
+	#undef LEN
+	#undef COS
+	#undef SIN
+}
+
+#undef V3
@@ -0,0 +1,247 @@
+#ifndef __INVERSE_KINEMATICS_SOA_H__
+#define __INVERSE_KINEMATICS_SOA_H__
+
+/* structure-of-arrays layout of an inverse kinematics chain: each node
+ * property lives in its own array so the solver passes (which only stream
+ * positions and directions) pull in nothing else. node `i` here is node `i`
+ * of the equivalent `struct ik_chain`. only circular limits are supported,
+ * elliptical ones are solved as a cone of their `aperture`. */
+struct ik_chain_soa {
+	short num_nodes;
+	real aperture;
+	real cos_ap, sin_ap;
+	vec3f rtn;
+	real* px, *py, *pz; // node positions
+	real* rx, *ry, *rz; // node directions
+	real* lengths;
+	real* apertures;
+	real* cos_ap_n, *sin_ap_n; // cosine and sine of `apertures`
+};
+
+/* allocates the node arrays for a chain of `_num_nodes` nodes (all arrays
+ * share a single allocation). (returns -1 on error) */
+int ik_soa_alloc(struct ik_chain_soa* _soa, short _num_nodes) {
+	real* block = malloc(10 * _num_nodes * sizeof(real));
+	if (!block) return -1;
+	
+	_soa->num_nodes = _num_nodes;
+	_soa->px = block + 0 * _num_nodes;
+	_soa->py = block + 1 * _num_nodes;
+	_soa->pz = block + 2 * _num_nodes;
+	_soa->rx = block + 3 * _num_nodes;
+	_soa->ry = block + 4 * _num_nodes;
+	_soa->rz = block + 5 * _num_nodes;
+	_soa->lengths = block + 6 * _num_nodes;
+	_soa->apertures = block + 7 * _num_nodes;
+	_soa->cos_ap_n = block + 8 * _num_nodes;
+	_soa->sin_ap_n = block + 9 * _num_nodes;
+	
+	return 0;
+}
+
+void ik_soa_free(struct ik_chain_soa* _soa) {
+	free(_soa->px);
+	_soa->px = _soa->py = _soa->pz = 0;
+	_soa->rx = _soa->ry = _soa->rz = 0;
+	_soa->lengths = _soa->apertures = _soa->cos_ap_n = _soa->sin_ap_n = 0;
+	_soa->num_nodes = 0;
+}
+
+static inline vec3f __ik_soa_pos(struct ik_chain_soa* _soa, int _k) {
+	return (vec3f) {_soa->px[_k], _soa->py[_k], _soa->pz[_k]};
+}
+
+static inline vec3f __ik_soa_rtn(struct ik_chain_soa* _soa, int _k) {
+	return (vec3f) {_soa->rx[_k], _soa->ry[_k], _soa->rz[_k]};
+}
+
+static inline void __ik_soa_set_pos(struct ik_chain_soa* _soa, int _k, vec3f _v) {
+	_soa->px[_k] = _v.x;
+	_soa->py[_k] = _v.y;
+	_soa->pz[_k] = _v.z;
+}
+
+static inline void __ik_soa_set_rtn(struct ik_chain_soa* _soa, int _k, vec3f _v) {
+	_soa->rx[_k] = _v.x;
+	_soa->ry[_k] = _v.y;
+	_soa->rz[_k] = _v.z;
+}
+
+/* allocates `_soa` and fills it with the contents of `_chain`.
+ * (returns -1 on error) */
+int ik_chain_to_soa(struct ik_chain_soa* _soa, struct ik_chain* _chain) {
+	if (ik_soa_alloc(_soa, _chain->num_nodes) == -1) return -1;
+	
+	_soa->aperture = _chain->aperture;
+	_soa->cos_ap = _chain->limit.cos_ap;
+	_soa->sin_ap = _chain->limit.sin_ap;
+	_soa->rtn = _chain->rtn;
+	
+	for (int i = 0; i < _chain->num_nodes; i++) {
+		__ik_soa_set_pos(_soa, i, _chain->nodes[i].pos);
+		__ik_soa_set_rtn(_soa, i, _chain->nodes[i].rtn);
+		_soa->lengths[i] = _chain->nodes[i].length;
+		_soa->apertures[i] = _chain->nodes[i].aperture;
+		_soa->cos_ap_n[i] = _chain->limits[i].cos_ap;
+		_soa->sin_ap_n[i] = _chain->limits[i].sin_ap;
+	}
+	
+	return 0;
+}
+
+/* writes the contents of `_soa` back into the (already allocated) nodes of
+ * `_chain` and updates its limits. (returns -1 if the chains differ in
+ * length) */
+int ik_soa_to_chain(struct ik_chain* _chain, struct ik_chain_soa* _soa) {
+	if (_chain->num_nodes != _soa->num_nodes) return -1;
+	
+	_chain->aperture = _soa->aperture;
+	_chain->rtn = _soa->rtn;
+	
+	for (int i = 0; i < _soa->num_nodes; i++) {
+		_chain->nodes[i].pos = __ik_soa_pos(_soa, i);
+		_chain->nodes[i].rtn = __ik_soa_rtn(_soa, i);
+		_chain->nodes[i].length = _soa->lengths[i];
+		_chain->nodes[i].aperture = _soa->apertures[i];
+	}
+	
+	ik_chain_update_limits(_chain);
+	return 0;
+}
+
+/* distance between the effector of a chain and `_target` */
+real ik_soa_error(struct ik_chain_soa* _soa, vec3f _target) {
+	return mag3f(sub3f(__ik_soa_pos(_soa, 0), _target));
+}
+
+/* same as `ik_chain_solve_ccd` but for a chain in SoA layout. every rotation
+ * is applied to all the nodes below the joint right away (in passes over
+ * contiguous arrays rather than through `struct ik_fk`), so an iteration is
+ * O(n^2), which only pays off for short chains. the pose matches the one of
+ * `ik_chain_solve_ccd` up to rounding. (returns -1 on error, `_res` still
+ * gets the iterations run) */
+int ik_soa_solve_ccd(struct ik_chain_soa* _soa, vec3f _target, real _rigidity, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	vec3f effector_vec; // vector from bone pivot to effector
+	vec3f target_vec; // vector from bone pivot to target
+	
+	struct ik_solve_opts opts = _opts ? *_opts : IK_CCD_DEFAULTS;
+	real error = ik_soa_error(_soa, _target);
+	real phi;
+	int i, ret = 0;
+	
+	for (i = 0; i < opts.max_iterations && error > opts.tolerance; ) {
+		for (short k = 1; k < _soa->num_nodes; k++) {
+			vec3f pivot = __ik_soa_pos(_soa, k);
+			effector_vec = sub3f(__ik_soa_pos(_soa, 0), pivot);
+			target_vec = sub3f(_target, pivot);
+			
+			real denom = (mag3f(effector_vec) * mag3f(target_vec));
+			real cos_phi = dot3f(effector_vec, target_vec) / denom;
+			
+			if (fabs(denom) < 0.0000000001) {
+				ret = -1;
+				break;
+			}
+			
+			// small angles from the cross product, as in ik_chain_solve_ccd
+			vec3f normal = cross3f(effector_vec, target_vec);
+			if (cos_phi > 0.999999999) phi = mag3f(normal) / denom;
+			else if (cos_phi < -0.999999999) phi = PI;
+			else phi = ACOS(cos_phi);
+			
+			if (phi == 0) continue;
+			
+			phi *= _rigidity;
+			
+			qtrn rot = make_qrot(norm3f(normal), phi);
+			
+			// the joint and every node downstream of it turn by `rot` (a
+			// single pass over contiguous arrays), then positions follow
+			qrot_soa(rot, _soa->rx, _soa->ry, _soa->rz, k + 1);
+			norm3f_soa(_soa->rx, _soa->ry, _soa->rz, k + 1);
+			
+			for (int n = k - 1; n >= 0; n--) {
+				real length = _soa->lengths[n + 1];
+				_soa->px[n] = _soa->px[n + 1] + length * _soa->rx[n + 1];
+				_soa->py[n] = _soa->py[n + 1] + length * _soa->ry[n + 1];
+				_soa->pz[n] = _soa->pz[n + 1] + length * _soa->rz[n + 1];
+			}
+		}
+		
+		if (ret == -1) break;
+		
+		i++;
+		real last_error = error;
+		error = ik_soa_error(_soa, _target);
+		if (last_error - error < opts.min_improvement) break;
+	}
+	
+	if (_res) *_res = (struct ik_solve_result) {i, ik_soa_error(_soa, _target)};
+	return ret;
+}
+
+/* same as `ik_chain_solve_fabrik` but for a chain in SoA layout. */
+int ik_soa_solve_fabrik(struct ik_chain_soa* _soa, vec3f _target, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	vec3f target; // current target position (not always `_target`)
+	vec3f joint_vec; // vector from joint to current target
+	int last = _soa->num_nodes - 1;
+	vec3f root = __ik_soa_pos(_soa, last); // root position of chain
+	
+	struct ik_solve_opts opts = _opts ? *_opts : IK_FABRIK_DEFAULTS;
+	real error = ik_soa_error(_soa, _target);
+	int k, i;
+	
+	for (i = 0; i < opts.max_iterations && error > opts.tolerance; ) {
+		// forward pass
+		target = _target;
+		__ik_soa_set_pos(_soa, 0, target);
+		
+		joint_vec = norm3f(sub3f(target, __ik_soa_pos(_soa, 1)));
+		target = sub3f(target, mul3f(joint_vec, _soa->lengths[1]));
+		__ik_soa_set_pos(_soa, 1, target);
+		__ik_soa_set_rtn(_soa, 1, joint_vec);
+		
+		for (k = 1; k < last - 1; k++) {
+			joint_vec = norm3f(sub3f(target, __ik_soa_pos(_soa, k + 1)));
+			joint_vec = __ik_clamp_vector_to_cone(__ik_soa_rtn(_soa, k), _soa->cos_ap_n[k], _soa->sin_ap_n[k], joint_vec);
+			
+			target = sub3f(target, mul3f(joint_vec, _soa->lengths[k + 1]));
+			__ik_soa_set_pos(_soa, k + 1, target);
+			__ik_soa_set_rtn(_soa, k + 1, joint_vec);
+		}
+		
+		// backward pass
+		target = root;
+		__ik_soa_set_pos(_soa, last, target);
+		
+		joint_vec = norm3f(sub3f(__ik_soa_pos(_soa, last - 1), target));
+		joint_vec = __ik_clamp_vector_to_cone(_soa->rtn, _soa->cos_ap, _soa->sin_ap, joint_vec);
+		target = add3f(target, mul3f(joint_vec, _soa->lengths[last]));
+		__ik_soa_set_pos(_soa, last - 1, target);
+		__ik_soa_set_rtn(_soa, last, joint_vec);
+		
+		for (k = last - 1; k > 0; k--) {
+			joint_vec = norm3f(sub3f(__ik_soa_pos(_soa, k - 1), target));
+			joint_vec = __ik_clamp_vector_to_cone(__ik_soa_rtn(_soa, k + 1), _soa->cos_ap_n[k + 1], _soa->sin_ap_n[k + 1], joint_vec);
+			
+			target = add3f(target, mul3f(joint_vec, _soa->lengths[k]));
+			__ik_soa_set_pos(_soa, k - 1, target);
+			__ik_soa_set_rtn(_soa, k, joint_vec);
+		}
+		
+		// set effector rotation
+		_soa->rx[0] = _soa->rx[1];
+		_soa->ry[0] = _soa->ry[1];
+		_soa->rz[0] = _soa->rz[1];
+		
+		i++;
+		real last_error = error;
+		error = ik_soa_error(_soa, _target);
+		if (last_error - error < opts.min_improvement) break;
+	}
+	
+	if (_res) *_res = (struct ik_solve_result) {i, error};
+	return 0;
+}
+
+#endif
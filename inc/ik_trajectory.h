@@ -0,0 +1,148 @@
+#ifndef __INVERSE_KINEMATICS_TRAJECTORY_H__
+#define __INVERSE_KINEMATICS_TRAJECTORY_H__
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/mman.h>
+
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void*) -1)
+#endif
+
+/* offline solving of recorded target trajectories. frame f of a trajectory
+ * is solved warm from the pose of frame f - 1 (see
+ * `ik_chain_solve_fabrik_warm`), and its pose is the `num_nodes` node poses
+ * starting at `poses[f * num_nodes]`. trajectories of different chains do
+ * not depend on each other and can be solved on a thread pool, and poses can
+ * be streamed into a file through a sliding mmap window, so that only one
+ * window of frames is ever in memory. */
+
+#define IK_TRAJECTORY_MAGIC "IKTJ"
+#define IK_TRAJECTORY_VERSION 1
+#ifndef IK_TRAJECTORY_WINDOW
+	#define IK_TRAJECTORY_WINDOW (1 << 20) // bytes of frames mapped at a time
+#endif
+
+struct ik_node_pose {
+	vec3f pos;
+	vec3f rtn;
+};
+
+/* start of a trajectory file, followed by `num_frames * num_nodes` node
+ * poses of `real_size` byte reals */
+struct ik_trajectory_header {
+	char magic[4];
+	uint16_t version;
+	uint16_t real_size;
+	uint32_t num_nodes;
+	uint32_t num_frames;
+};
+
+/* internal function that copies the pose of a chain into `_pose` */
+void __ik_store_pose(struct ik_chain* _chain, struct ik_node_pose* _pose) {
+	for (int k = 0; k < _chain->num_nodes; k++)
+		_pose[k] = (struct ik_node_pose) {_chain->nodes[k].pos, _chain->nodes[k].rtn};
+}
+
+/* solves `_chain` towards `_targets[0]` to `_targets[_num_frames - 1]` in
+ * turn, storing the pose of every frame in `_poses` (room for `_num_frames *
+ * _chain->num_nodes` node poses) and its outcome in `_results` (may be null).
+ * `_opts` may be null to use `IK_WARM_DEFAULTS`. the chain is left in the
+ * pose of the last frame. */
+int ik_chain_solve_trajectory(struct ik_chain* _chain, vec3f* _targets, int _num_frames, struct ik_node_pose* _poses, struct ik_warm_opts* _opts, struct ik_solve_result* _results) {
+	for (int f = 0; f < _num_frames; f++) {
+		if (ik_chain_solve_fabrik_warm(_chain, _targets[f], _opts, _results ? &_results[f] : 0) == -1) return -1;
+		__ik_store_pose(_chain, &_poses[f * _chain->num_nodes]);
+	}
+	
+	return 0;
+}
+
+/* same as `ik_chain_solve_trajectory` but the poses are written to the file
+ * at `_path` (created or truncated) behind a `struct ik_trajectory_header`,
+ * `IK_TRAJECTORY_WINDOW` bytes at a time. (returns -1 on error) */
+int ik_chain_solve_trajectory_file(struct ik_chain* _chain, vec3f* _targets, int _num_frames, const char* _path, struct ik_warm_opts* _opts) {
+	size_t frame_size = _chain->num_nodes * sizeof(struct ik_node_pose);
+	size_t page = sysconf(_SC_PAGESIZE);
+	int frames_per_window = IK_TRAJECTORY_WINDOW / frame_size;
+	if (frames_per_window < 1) frames_per_window = 1;
+	
+	int fd = open(_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) return -1;
+	
+	struct ik_trajectory_header header = {
+		IK_TRAJECTORY_MAGIC, IK_TRAJECTORY_VERSION, sizeof(real), _chain->num_nodes, _num_frames
+	};
+	
+	if (
+		write(fd, &header, sizeof(header)) != sizeof(header) ||
+		ftruncate(fd, sizeof(header) + _num_frames * frame_size) == -1
+	) {
+		close(fd);
+		return -1;
+	}
+	
+	for (int first = 0; first < _num_frames; first += frames_per_window) {
+		int count = _num_frames - first < frames_per_window ? _num_frames - first : frames_per_window;
+		
+		// mappings start on a page, the window's first frame usually does not
+		size_t start = sizeof(header) + first * frame_size;
+		size_t map_start = start & ~(page - 1);
+		size_t map_len = start - map_start + count * frame_size;
+		
+		char* map = mmap(0, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, map_start);
+		if (map == MAP_FAILED) {
+			close(fd);
+			return -1;
+		}
+		
+		int ret = ik_chain_solve_trajectory(_chain, &_targets[first], count, (struct ik_node_pose*) (map + start - map_start), _opts, 0);
+		munmap(map, map_len);
+		
+		if (ret == -1) {
+			close(fd);
+			return -1;
+		}
+	}
+	
+	return close(fd);
+}
+
+/* a trajectory of one chain, solved as one thread pool job. `poses` is used
+ * if `path` is null. */
+struct ik_trajectory_job {
+	struct ik_chain* chain;
+	vec3f* targets;
+	int num_frames;
+	struct ik_node_pose* poses;
+	const char* path;
+	struct ik_warm_opts* opts;
+	int ret;
+};
+
+void __ik_trajectory_job(void* _arg) {
+	struct ik_trajectory_job* job = _arg;
+	
+	job->ret = job->path
+		? ik_chain_solve_trajectory_file(job->chain, job->targets, job->num_frames, job->path, job->opts)
+		: ik_chain_solve_trajectory(job->chain, job->targets, job->num_frames, job->poses, job->opts, 0);
+}
+
+/* solves the trajectories of `_num_jobs` different chains at the same time on
+ * the workers of `_pool` (which should be able to queue `_num_jobs` jobs).
+ * (returns -1 if any of them failed, see each job's `ret`) */
+int ik_solve_trajectories_mt(struct ik_trajectory_job* _jobs, int _num_jobs, struct tp_pool* _pool) {
+	// run it here if the pool's queue is full
+	for (int i = 0; i < _num_jobs; i++)
+		if (tp_submit(_pool, __ik_trajectory_job, &_jobs[i]) == -1) __ik_trajectory_job(&_jobs[i]);
+	
+	tp_wait(_pool);
+	
+	int ret = 0;
+	for (int i = 0; i < _num_jobs; i++)
+		if (_jobs[i].ret == -1) ret = -1;
+	
+	return ret;
+}
+
+#endif
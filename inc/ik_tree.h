@@ -0,0 +1,328 @@
+#ifndef __INVERSE_KINEMATICS_TREE_H__
+#define __INVERSE_KINEMATICS_TREE_H__
+
+/* skeleton trees solved with multiple end effector FABRIK. a tree is cut
+ * into segments, runs of nodes without branches that end at a leaf or at a
+ * sub-base (a node with several children). the forward pass solves segments
+ * from the leaves inwards, each sub-base taking the average of the positions
+ * its child segments want it at, and the backward pass goes from the root
+ * outwards. segments that share a level (the number of sub-bases above them)
+ * do not touch each other's nodes, so `ik_tree_solve_fabrik_mt` solves them
+ * in parallel. a whole character (legs, arms and head on one spine) is one
+ * call instead of several chains fighting over the shared bones. */
+
+struct ik_tree;
+
+/* a joint of a skeleton tree, node 0 is the root */
+struct ik_tree_node {
+	short parent; // -1 for the root
+	real length; // of the bone from the parent
+	real aperture; // limit of the bone relative to the parent's bone
+	struct ik_limit limit;
+	vec3f pos;
+	vec3f rtn; // direction of the bone from the parent
+	short first_child, next_sibling; // -1 if none
+	short num_children;
+	short target; // index of this node's target in the current solve, or -1
+};
+
+/* nodes `tree->order[first]` to `tree->order[first + count - 1]` from the
+ * top down, the bottom one being a leaf or a sub-base */
+struct ik_tree_segment {
+	struct ik_tree* tree;
+	short first, count;
+	short level; // number of sub-bases above the segment
+	short first_child, num_children; // segments hanging off the bottom node
+	short active; // set if the segment leads to a target in the current solve
+	vec3f proposal; // where the forward pass wants the parent of the top node
+};
+
+struct ik_tree {
+	struct ik_tree_node* nodes;
+	short num_nodes, max_nodes;
+	struct ik_tree_segment* segments; // breadth first, so grouped by level
+	short num_segments;
+	short* order; // node indices grouped by segment
+	short built; // set while `segments` matches the nodes
+	struct ik_target* targets; // of the current solve
+};
+
+/* allocates a tree of up to `_max_nodes` nodes (nodes are then added with
+ * `ik_tree_add`). (returns -1 on error) */
+int ik_tree_alloc(struct ik_tree* _tree, short _max_nodes) {
+	_tree->num_nodes = _tree->num_segments = 0;
+	_tree->max_nodes = _max_nodes;
+	_tree->built = 0;
+	
+	_tree->nodes = malloc(_max_nodes * sizeof(struct ik_tree_node));
+	_tree->segments = malloc(_max_nodes * sizeof(struct ik_tree_segment));
+	_tree->order = malloc(_max_nodes * sizeof(short));
+	
+	if (!_tree->nodes || !_tree->segments || !_tree->order) {
+		free(_tree->nodes);
+		free(_tree->segments);
+		free(_tree->order);
+		_tree->nodes = 0;
+		_tree->segments = 0;
+		_tree->order = 0;
+		return -1;
+	}
+	
+	return 0;
+}
+
+void ik_tree_free(struct ik_tree* _tree) {
+	free(_tree->nodes);
+	free(_tree->segments);
+	free(_tree->order);
+	_tree->nodes = 0;
+	_tree->segments = 0;
+	_tree->order = 0;
+	_tree->num_nodes = _tree->max_nodes = _tree->num_segments = 0;
+}
+
+/* adds a node at `_pos` below `_parent` (-1 for the root, which must be the
+ * first node), with a circular limit of `_aperture` relative to the parent's
+ * bone. bones leaving the root are not limited. (returns the index of the
+ * node, or -1 if the tree is full, `_parent` does not exist or the bone would
+ * have no length) */
+short ik_tree_add(struct ik_tree* _tree, short _parent, vec3f _pos, real _aperture) {
+	if (_tree->num_nodes == _tree->max_nodes) return -1;
+	if (_parent == -1 ? _tree->num_nodes != 0 : _parent < 0 || _parent >= _tree->num_nodes) return -1;
+	
+	struct ik_tree_node* n = &_tree->nodes[_tree->num_nodes];
+	*n = (struct ik_tree_node) {_parent, 0, _aperture};
+	n->pos = _pos;
+	n->rtn = (vec3f) {1, 0, 0};
+	n->limit = (struct ik_limit) {.type = IK_LIMIT_CONE, .aperture_y = _aperture, .up = {0, 0, 1}};
+	__ik_update_limit(&n->limit, _aperture);
+	
+	if (_parent != -1) {
+		vec3f bone = sub3f(_pos, _tree->nodes[_parent].pos);
+		n->length = mag3f(bone);
+		if (n->length < 0.0000000001) return -1;
+		n->rtn = mul3f(bone, 1 / n->length);
+	}
+	
+	_tree->built = 0;
+	return _tree->num_nodes++;
+}
+
+/* recomputes what the solvers cache about the joint limits of a tree, call
+ * after changing an `aperture`, `limit.aperture_y` or `limit.type`. */
+void ik_tree_update_limits(struct ik_tree* _tree) {
+	for (int i = 0; i < _tree->num_nodes; i++)
+		__ik_update_limit(&_tree->nodes[i].limit, _tree->nodes[i].aperture);
+}
+
+/* internal function that links the children of every node and cuts the tree
+ * into segments (breadth first over the segments, so that the children of a
+ * segment and the segments of a level are next to each other) */
+void __ik_tree_build(struct ik_tree* _tree) {
+	struct ik_tree_node* nodes = _tree->nodes;
+	
+	for (int i = 0; i < _tree->num_nodes; i++) {
+		nodes[i].first_child = nodes[i].next_sibling = -1;
+		nodes[i].num_children = 0;
+	}
+	
+	// linked backwards so that children end up in index order
+	for (int i = _tree->num_nodes - 1; i > 0; i--) {
+		struct ik_tree_node* p = &nodes[nodes[i].parent];
+		nodes[i].next_sibling = p->first_child;
+		p->first_child = i;
+		p->num_children++;
+	}
+	
+	// the segments array doubles as the breadth first queue, a segment only
+	// knows its top node (kept in `first`) until it is dequeued
+	int num = 0, next = 0;
+	for (int c = nodes[0].first_child; c != -1; c = nodes[c].next_sibling)
+		_tree->segments[num++] = (struct ik_tree_segment) {_tree, c, 0, 0};
+	
+	for (int s = 0; s < num; s++) {
+		struct ik_tree_segment* seg = &_tree->segments[s];
+		int node = seg->first;
+		
+		seg->first = next;
+		_tree->order[next++] = node;
+		while (nodes[node].num_children == 1) {
+			node = nodes[node].first_child;
+			_tree->order[next++] = node;
+		}
+		seg->count = next - seg->first;
+		
+		seg->first_child = num;
+		seg->num_children = nodes[node].num_children;
+		for (int c = nodes[node].first_child; c != -1; c = nodes[c].next_sibling)
+			_tree->segments[num++] = (struct ik_tree_segment) {_tree, c, 0, seg->level + 1};
+	}
+	
+	_tree->num_segments = num;
+	_tree->built = 1;
+}
+
+/* largest distance between a target and its node */
+real ik_tree_error(struct ik_tree* _tree, struct ik_target* _targets, int _num_targets) {
+	real error = 0;
+	
+	for (int t = 0; t < _num_targets; t++) {
+		real d = mag3f(sub3f(_tree->nodes[_targets[t].node].pos, _targets[t].pos));
+		if (d > error) error = d;
+	}
+	
+	return error;
+}
+
+/* internal function that runs the forward pass over one segment, from its
+ * bottom node up */
+void __ik_tree_forward(void* _arg) {
+	struct ik_tree_segment* seg = _arg;
+	struct ik_tree* tree = seg->tree;
+	struct ik_tree_node* nodes = tree->nodes;
+	short* order = tree->order + seg->first;
+	
+	// a sub-base sits at the average of where its active child segments
+	// want it (its own target wins if it has one)
+	vec3f pos = {0, 0, 0};
+	int n = 0;
+	for (int c = seg->first_child; c < seg->first_child + seg->num_children; c++) {
+		if (!tree->segments[c].active) continue;
+		pos = add3f(pos, tree->segments[c].proposal);
+		n++;
+	}
+	if (n) pos = mul3f(pos, (real) 1 / n);
+	
+	// without active child segments the pass starts at the deepest target,
+	// the nodes below it are not pulled anywhere and follow in the backward
+	// pass
+	int bottom = seg->count - 1;
+	if (!n) while (nodes[order[bottom]].target == -1) bottom--;
+	
+	vec3f child_rtn = {0, 0, 0};
+	struct ik_limit* child_limit = 0; // none below a sub-base
+	if (bottom < seg->count - 1) {
+		child_rtn = nodes[order[bottom + 1]].rtn;
+		child_limit = &nodes[order[bottom + 1]].limit;
+	}
+	
+	for (int j = bottom; j >= 0; j--) {
+		struct ik_tree_node* node = &nodes[order[j]];
+		if (node->target != -1) pos = tree->targets[node->target].pos;
+		node->pos = pos;
+		
+		vec3f joint_vec = norm3f(sub3f(pos, nodes[node->parent].pos));
+		if (child_limit) joint_vec = __ik_clamp_vector_to_limit(child_rtn, child_limit, joint_vec);
+		
+		node->rtn = joint_vec;
+		pos = sub3f(pos, mul3f(joint_vec, node->length));
+		child_rtn = joint_vec;
+		child_limit = &node->limit;
+	}
+	
+	seg->proposal = pos;
+}
+
+/* internal function that runs the backward pass over one segment, from its
+ * top node down */
+void __ik_tree_backward(void* _arg) {
+	struct ik_tree_segment* seg = _arg;
+	struct ik_tree_node* nodes = seg->tree->nodes;
+	short* order = seg->tree->order + seg->first;
+	
+	for (int j = 0; j < seg->count; j++) {
+		struct ik_tree_node* node = &nodes[order[j]];
+		struct ik_tree_node* parent = &nodes[node->parent];
+		
+		vec3f joint_vec = norm3f(sub3f(node->pos, parent->pos));
+		if (node->parent != 0) joint_vec = __ik_clamp_vector_to_limit(parent->rtn, &node->limit, joint_vec);
+		
+		node->pos = add3f(parent->pos, mul3f(joint_vec, node->length));
+		node->rtn = joint_vec;
+	}
+}
+
+/* internal function that runs `_fn` on the segments `_first` to `_last - 1`
+ * (one level), through `_pool` if there is one and more than one segment */
+void __ik_tree_run_level(struct ik_tree* _tree, int _first, int _last, int _active_only, void (*_fn)(void*), struct tp_pool* _pool) {
+	for (int s = _first; s < _last; s++) {
+		struct ik_tree_segment* seg = &_tree->segments[s];
+		if (_active_only && !seg->active) continue;
+		
+		// run it here if the pool's queue is full
+		if (!_pool || _last - _first == 1 || tp_submit(_pool, _fn, seg) == -1) _fn(seg);
+	}
+	
+	if (_pool && _last - _first > 1) tp_wait(_pool);
+}
+
+/* internal function shared by the tree solvers, `_pool` may be null */
+int __ik_tree_solve_fabrik(struct ik_tree* _tree, struct ik_target* _targets, int _num_targets, struct ik_solve_opts* _opts, struct ik_solve_result* _res, struct tp_pool* _pool) {
+	if (_tree->num_nodes < 2) return -1;
+	for (int t = 0; t < _num_targets; t++)
+		if (_targets[t].node < 1 || _targets[t].node >= _tree->num_nodes) return -1;
+	
+	if (!_tree->built) __ik_tree_build(_tree);
+	
+	struct ik_solve_opts opts = _opts ? *_opts : IK_FABRIK_DEFAULTS;
+	struct ik_tree_segment* segs = _tree->segments;
+	vec3f root = _tree->nodes[0].pos;
+	
+	_tree->targets = _targets;
+	for (int i = 0; i < _tree->num_nodes; i++) _tree->nodes[i].target = -1;
+	for (int t = 0; t < _num_targets; t++) _tree->nodes[_targets[t].node].target = t;
+	
+	// a segment is active if it or a segment below it holds a target
+	for (int s = _tree->num_segments - 1; s >= 0; s--) {
+		segs[s].active = 0;
+		for (int j = segs[s].first; j < segs[s].first + segs[s].count; j++)
+			if (_tree->nodes[_tree->order[j]].target != -1) segs[s].active = 1;
+		for (int c = segs[s].first_child; c < segs[s].first_child + segs[s].num_children; c++)
+			if (segs[c].active) segs[s].active = 1;
+	}
+	
+	real error = ik_tree_error(_tree, _targets, _num_targets);
+	int i, first, last;
+	
+	for (i = 0; i < opts.max_iterations && error > opts.tolerance; ) {
+		// forward pass, deepest level first
+		for (last = _tree->num_segments; last > 0; last = first) {
+			for (first = last - 1; first > 0 && segs[first - 1].level == segs[last - 1].level; first--);
+			__ik_tree_run_level(_tree, first, last, 1, __ik_tree_forward, _pool);
+		}
+		
+		// backward pass, from the root outwards
+		_tree->nodes[0].pos = root;
+		for (first = 0; first < _tree->num_segments; first = last) {
+			for (last = first + 1; last < _tree->num_segments && segs[last].level == segs[first].level; last++);
+			__ik_tree_run_level(_tree, first, last, 0, __ik_tree_backward, _pool);
+		}
+		
+		// stop early once an iteration no longer gets the effectors closer
+		i++;
+		real last_error = error;
+		error = ik_tree_error(_tree, _targets, _num_targets);
+		if (last_error - error < opts.min_improvement) break;
+	}
+	
+	if (_res) *_res = (struct ik_solve_result) {i, error};
+	return 0;
+}
+
+/* solves a tree towards `_num_targets` targets (at most one per node, and
+ * not the root) with multiple end effector FABRIK. the error is the largest
+ * distance between a target and its node. `_opts` may be null to use
+ * `IK_FABRIK_DEFAULTS`, and `_res` may be null. (returns -1 on error) */
+int ik_tree_solve_fabrik(struct ik_tree* _tree, struct ik_target* _targets, int _num_targets, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
+	return __ik_tree_solve_fabrik(_tree, _targets, _num_targets, _opts, _res, 0);
+}
+
+/* same as `ik_tree_solve_fabrik`, but the segments of a level are spread
+ * across the workers of `_pool` (which should be able to queue as many jobs
+ * as the tree has segments). only worth it for trees with long branches, the
+ * pool is synchronised once per level and pass. */
+int ik_tree_solve_fabrik_mt(struct ik_tree* _tree, struct ik_target* _targets, int _num_targets, struct ik_solve_opts* _opts, struct ik_solve_result* _res, struct tp_pool* _pool) {
+	return __ik_tree_solve_fabrik(_tree, _targets, _num_targets, _opts, _res, _pool);
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 void fb_draw_point(rgbx32 _col, int x, int y) {
 	if (y >= 2 && x >= 2 && y < fb_vinfo.yres - 2 && x < fb_vinfo.xres - 2) {
+		fb_damage_rect(x - 2, y - 2, x + 2, y + 2);
+		
 		sbuf[y - 2][x - 1] = _col;
 		sbuf[y - 2][x - 0] = _col;
 		sbuf[y - 2][x + 1] = _col;
@@ -33,6 +35,8 @@ void fb_draw_point(rgbx32 _col, int x, int y) {
 
 void fb_draw_centroid(rgbx32 _col, int x, int y) {
 	if (y >= 2 && x >= 2 && y < fb_vinfo.yres - 2 && x < fb_vinfo.xres - 2) {
+		fb_damage_rect(x - 2, y - 2, x + 2, y + 2);
+		
 		sbuf[y - 2][x - 1] = (rgbx32) {255, 255, 255, 255};
 		sbuf[y - 2][x - 0] = (rgbx32) {255, 255, 255, 255};
 		sbuf[y - 2][x + 1] = (rgbx32) {255, 255, 255, 255};
@@ -70,8 +74,10 @@ void fb_draw_line(rgbx32 _col, int x1, int y1, int x2, int y2) {
 	int e2;
 	
 	while (x1 != x2 || y1 != y2) {
-		if (y1 >= 0 && x1 >= 0 && y1 < fb_vinfo.yres && x1 < fb_vinfo.xres)
+		if (y1 >= 0 && x1 >= 0 && y1 < fb_vinfo.yres && x1 < fb_vinfo.xres) {
 			sbuf[y1][x1] = _col;
+			fb_damage_point(x1, y1);
+		}
 		e2 = 2 * er;
 		if (e2 >= dy) er += dy, x1 += sx;
 		if (e2 <= dx) er += dx, y1 += sy;
@@ -1,6 +1,25 @@
 #ifndef __CRD_LINEAR_ALGEBRA_H__
 #define __CRD_LINEAR_ALGEBRA_H__
 
+#include <stdint.h>
+
+/* `LINALG_DETERMINISTIC` makes results the same bit for bit on every build
+ * and machine (given SSE2 or another IEEE double unit, not the x87): RSQRT
+ * becomes an IEEE square root (which is correctly rounded) and ACOS and
+ * SINCOS the `LINALG_FAST` polynomials (which only use basic arithmetic),
+ * so no libm transcendental (which differ between implementations) is
+ * called. multiply-adds are not fused into FMAs in anything included after
+ * this header (gcc also needs its SLP vectoriser off for that, it fuses
+ * add/sub pairs regardless), and the AVX2 paths are disabled. the math
+ * tier setting (see below) is ignored. */
+#ifdef LINALG_DETERMINISTIC
+	#ifdef __clang__
+		#pragma STDC FP_CONTRACT OFF
+	#else
+		#pragma GCC optimize ("fp-contract=off", "no-tree-slp-vectorize")
+	#endif
+#endif
+
 // basic math
 
 #define CLAMP(N, HIGH, LOW) ( ((N) < (LOW)) ? (N) = (LOW) : ((N) > (HIGH)) ? (N) = (HIGH) : 0 )
@@ -10,63 +29,83 @@
 
 #define PI 3.1415926535897932384626
 
+/* every vector, quaternion and matrix holds `real`s, which are doubles
+ * unless `LINALG_FLOAT` is defined before this header is included. the
+ * REAL_* constants are the bit patterns the fast functions below start from
+ * for that precision. */
+#ifdef LINALG_FLOAT
+	typedef float real;
+	typedef uint32_t real_bits;
+	#define REAL_ABS_MASK 0x7FFFFFFF
+	#define REAL_SQRT_BIAS 0x1FC00000
+	#define REAL_INV_MAGIC 0x7F000000
+	#define REAL_ISQRT_MAGIC 0x5F3759DF
+#else
+	typedef double real;
+	typedef uint64_t real_bits;
+	#define REAL_ABS_MASK 0x7FFFFFFFFFFFFFFF
+	#define REAL_SQRT_BIAS 0x1FF8000000000000
+	#define REAL_INV_MAGIC 0x7FE0000000000000
+	#define REAL_ISQRT_MAGIC 0x5FE6EB50C7B537A9
+#endif
+
 /* floating point absolute value (unset sign bit)*/
-extern inline double FABS(double X) {
-	*((uint_fast64_t*) &X) &= 0x7FFFFFFFFFFFFFFF;
+extern inline real FABS(real X) {
+	*((real_bits*) &X) &= REAL_ABS_MASK;
 	return X;
 }
 
 /* floor function / gauss bracket */
-extern inline int FLOOR(double X) {
+extern inline int FLOOR(real X) {
 	int r = (int) X;
 	return r - (r > X);
 }
 
 /* ceil function */
-extern inline int CEIL(double X) {
+extern inline int CEIL(real X) {
 	int r = (int) X;
 	return r + (r < X);
 }
 
 /* fast square root (not perfect, but was fun to derive) */
-extern inline double FSQRT(double _x) {
+extern inline real FSQRT(real _x) {
 	/// initial guess
-	uint64_t u = (*((uint64_t*) &_x) >> 1) + 0x1FF8000000000000;
+	real_bits u = (*((real_bits*) &_x) >> 1) + REAL_SQRT_BIAS;
 	
 	/// newton's method
-	*((double*) &u) = 0.5 * (*((double*) &u) + _x / *((double*) &u));
-	//*((double*) &u) = 0.5 * (*((double*) &u) + _x / *((double*) &u));
-	//*((double*) &u) = 0.5 * (*((double*) &u) + _x / *((double*) &u));
+	*((real*) &u) = 0.5 * (*((real*) &u) + _x / *((real*) &u));
+	//*((real*) &u) = 0.5 * (*((real*) &u) + _x / *((real*) &u));
+	//*((real*) &u) = 0.5 * (*((real*) &u) + _x / *((real*) &u));
 	
-	return *((double*) &u);
+	return *((real*) &u);
 }
 
 /* fast inverse (also fun to derive, but not very practical) */
-extern inline double FINV(double _x) {
-	uint64_t u = 0x7FE0000000000000 - *((uint64_t*) &_x);
-	return *((double*) &u);
+extern inline real FINV(real _x) {
+	real_bits u = REAL_INV_MAGIC - *((real_bits*) &_x);
+	return *((real*) &u);
 }
 
 /* infamous. */
-extern inline double FISQRT(double _x) {
+extern inline real FISQRT(real _x) {
 	/// initial guess
-	uint64_t u = 0x5FE8000000000000 - (*((uint64_t*) &_x) >> 1);
+	real_bits u = REAL_ISQRT_MAGIC - (*((real_bits*) &_x) >> 1);
 	
 	/// newton's method
-	*((double*) &u) *= 1.5 - (0.5 * _x * (*((double*) &u)) * (*((double*) &u)));
-	//*((double*) &u) *= 1.5 - (0.5 * _x * (*((double*) &u)) * (*((double*) &u)));
-	*((double*) &u) *= 1.5 - (0.5 * _x * (*((double*) &u)) * (*((double*) &u)));
+	*((real*) &u) *= (real) 1.5 - ((real) 0.5 * _x * (*((real*) &u)) * (*((real*) &u)));
+	//*((real*) &u) *= (real) 1.5 - ((real) 0.5 * _x * (*((real*) &u)) * (*((real*) &u)));
+	*((real*) &u) *= (real) 1.5 - ((real) 0.5 * _x * (*((real*) &u)) * (*((real*) &u)));
 	
-	return *((double*) &u);
+	return *((real*) &u);
 }
 
 /* fucking math.h doesnt work 70% the time when x = 1.0 because of
  * floating point errors so I had to rip this from nvidia and change
  * 1.0 to 1.0000000001 (very brute force patch) */
-double acos_that_actually_works(double x) {
-	double negate = (double) (x < 0);
+real acos_that_actually_works(real x) {
+	real negate = (real) (x < 0);
 	x = FABS(x);
-	double ret = (
+	real ret = (
 		(((-0.0187293 * x + 0.0742610) * x - 0.2121144) * x + 1.5707288)
 		* sqrt(1.0000000001 - x)
 	);
@@ -74,6 +113,125 @@ double acos_that_actually_works(double x) {
 	return negate * 3.14159265358979 + ret;
 }
 
+// math tiers
+
+/* the square roots and trigonometry the solvers lean on come in three tiers,
+ * picked by defining `LINALG_MATH_TIER` before including this header. the
+ * tiers trade accuracy for speed (largest error over the whole input range,
+ * floats add their own rounding on top):
+ *
+ *                   RSQRT (rel.)   ACOS (rad)   SINCOS (abs.)
+ *  LINALG_EXACT     libm           libm         libm
+ *  LINALG_FAST      4.6e-6         6.8e-5       3.2e-7
+ *  LINALG_FASTEST   1.8e-3         3.3e-3       3.7e-5
+ *
+ * `LINALG_FAST` is the default. it is not quite what the library used
+ * before the tiers: make_qrot called libm sin and cos (now `sincos_fast`),
+ * the cone clamp called libm acos (now `acos_fast`, the CCD polynomial) and
+ * the double FISQRT magic was 0x5FE8000000000000 (now 0x5FE6EB50C7B537A9,
+ * 2.2e-4 down to 4.6e-6 after two newton steps). `LINALG_EXACT` gives the
+ * libm results back. every tier's functions are always defined (for
+ * comparing them, see tests/math.c), the RSQRT, ACOS and SINCOS macros
+ * select the configured ones. */
+
+#define LINALG_EXACT 0
+#define LINALG_FAST 1
+#define LINALG_FASTEST 2
+
+#ifndef LINALG_MATH_TIER
+	#define LINALG_MATH_TIER LINALG_FAST
+#endif
+
+real rsqrt_exact(real _x) { return 1 / sqrt(_x); }
+real rsqrt_fast(real _x) { return FISQRT(_x); }
+
+/* `FISQRT` with a single newton step */
+real rsqrt_fastest(real _x) {
+	real_bits u = REAL_ISQRT_MAGIC - (*((real_bits*) &_x) >> 1);
+	*((real*) &u) *= (real) 1.5 - ((real) 0.5 * _x * (*((real*) &u)) * (*((real*) &u)));
+	return *((real*) &u);
+}
+
+/* libm's acos, with the input clamped to [-1, 1] so rounding can not make it
+ * return nan */
+real acos_exact(real _x) {
+	CLAMP(_x, 1.0, -1.0);
+	return acos(_x);
+}
+
+real acos_fast(real _x) { return acos_that_actually_works(_x); }
+
+/* same shape as `acos_that_actually_works` with a first order polynomial */
+real acos_fastest(real _x) {
+	real negate = (real) (_x < 0);
+	_x = FABS(_x);
+	real ret = (1.5676 - 0.1683 * _x) * sqrt(1 - _x);
+	ret = ret - 2.0 * negate * ret;
+	return negate * PI + ret;
+}
+
+void sincos_exact(real _x, real* _sin, real* _cos) {
+	*_sin = sin(_x);
+	*_cos = cos(_x);
+}
+
+/* internal function that reduces `_x` to `_r` in [-pi/4, pi/4], returning
+ * which quarter turn it was in (0 to 3). */
+int __linalg_quadrant(real _x, real* _r) {
+	real q = nearbyint(_x * (2 / PI));
+	*_r = _x - q * (PI / 2);
+	return (int) (q - 4 * floor(q * 0.25));
+}
+
+/* internal function that turns the sine and cosine of the reduced angle back
+ * into those of the original one */
+void __linalg_unquadrant(int _q, real _s, real _c, real* _sin, real* _cos) {
+	switch (_q) {
+		case 0: *_sin = _s;  *_cos = _c;  break;
+		case 1: *_sin = _c;  *_cos = -_s; break;
+		case 2: *_sin = -_s; *_cos = -_c; break;
+		case 3: *_sin = -_c; *_cos = _s;  break;
+	}
+}
+
+/* taylor series up to x^7 / x^8 on the reduced angle */
+void sincos_fast(real _x, real* _sin, real* _cos) {
+	real r;
+	int q = __linalg_quadrant(_x, &r);
+	real r2 = r * r;
+	real s = r * (1 + r2 * (-1.0 / 6 + r2 * (1.0 / 120 + r2 * (-1.0 / 5040))));
+	real c = 1 + r2 * (-0.5 + r2 * (1.0 / 24 + r2 * (-1.0 / 720 + r2 * (1.0 / 40320))));
+	__linalg_unquadrant(q, s, c, _sin, _cos);
+}
+
+/* taylor series up to x^5 / x^6 on the reduced angle */
+void sincos_fastest(real _x, real* _sin, real* _cos) {
+	real r;
+	int q = __linalg_quadrant(_x, &r);
+	real r2 = r * r;
+	real s = r * (1 + r2 * (-1.0 / 6 + r2 * (1.0 / 120)));
+	real c = 1 + r2 * (-0.5 + r2 * (1.0 / 24 + r2 * (-1.0 / 720)));
+	__linalg_unquadrant(q, s, c, _sin, _cos);
+}
+
+#ifdef LINALG_DETERMINISTIC
+	#define RSQRT rsqrt_exact
+	#define ACOS acos_fast
+	#define SINCOS sincos_fast
+#elif LINALG_MATH_TIER == LINALG_EXACT
+	#define RSQRT rsqrt_exact
+	#define ACOS acos_exact
+	#define SINCOS sincos_exact
+#elif LINALG_MATH_TIER == LINALG_FASTEST
+	#define RSQRT rsqrt_fastest
+	#define ACOS acos_fastest
+	#define SINCOS sincos_fastest
+#else
+	#define RSQRT rsqrt_fast
+	#define ACOS acos_fast
+	#define SINCOS sincos_fast
+#endif
+
 /* minimum and maximums */
 
 int min(int _a, int _b) { return _a + (_b < _a) * (_b - _a); }
@@ -108,9 +266,9 @@ double fmax3(double _a, double _b, double _c) {
 
 // vectors
 
-typedef struct { double x, y, z, w; } vec4f;
-typedef struct { double x, y, z;    } vec3f;
-typedef struct { double x, y;       } vec2f;
+typedef struct { real x, y, z, w; } vec4f;
+typedef struct { real x, y, z;    } vec3f;
+typedef struct { real x, y;       } vec2f;
 
 /* vector subtraction */
 vec2f sub2f(vec2f _a, vec2f _b) { return (vec2f) {_a.x - _b.x, _a.y - _b.y}; }
@@ -123,9 +281,9 @@ vec3f add3f(vec3f _a, vec3f _b) { return (vec3f) {_a.x + _b.x, _a.y + _b.y, _a.z
 vec4f add4f(vec4f _a, vec4f _b) { return (vec4f) {_a.x + _b.x, _a.y + _b.y, _a.z + _b.z, _a.w + _b.w}; }
 
 /* scalar multiplication */
-vec2f mul2f(vec2f _v, double _c) { return (vec2f) {_v.x * _c, _v.y * _c}; }
-vec3f mul3f(vec3f _v, double _c) { return (vec3f) {_v.x * _c, _v.y * _c, _v.z * _c}; }
-vec4f mul4f(vec4f _v, double _c) { return (vec4f) {_v.x * _c, _v.y * _c, _v.z * _c, _v.w * _c}; }
+vec2f mul2f(vec2f _v, real _c) { return (vec2f) {_v.x * _c, _v.y * _c}; }
+vec3f mul3f(vec3f _v, real _c) { return (vec3f) {_v.x * _c, _v.y * _c, _v.z * _c}; }
+vec4f mul4f(vec4f _v, real _c) { return (vec4f) {_v.x * _c, _v.y * _c, _v.z * _c, _v.w * _c}; }
 
 /* vector negation */
 vec2f neg2f(vec2f _v) { return (vec2f) {-_v.x, -_v.y}; }
@@ -144,37 +302,37 @@ vec3f cross3f(vec3f _a, vec3f _b) {
 /* returns the resulting z conponent of the cross product after 2d
  * vectors are augmented with zero (notably useful in the world of
  * computer graphics) */
-double cross2f(vec3f _a, vec3f _b) { return _a.x * _b.y - _a.y * _b.x; }
+real cross2f(vec3f _a, vec3f _b) { return _a.x * _b.y - _a.y * _b.x; }
 
 /* dot products */
-double dot2f(vec2f _a, vec2f _b) { return _a.x * _b.x + _a.y * _b.y; }
-double dot3f(vec3f _a, vec3f _b) { return _a.x * _b.x + _a.y * _b.y + _a.z * _b.z; }
-double dot4f(vec4f _a, vec4f _b) { return _a.x * _b.x + _a.y * _b.y + _a.z * _b.z + _a.w * _b.w; }
+real dot2f(vec2f _a, vec2f _b) { return _a.x * _b.x + _a.y * _b.y; }
+real dot3f(vec3f _a, vec3f _b) { return _a.x * _b.x + _a.y * _b.y + _a.z * _b.z; }
+real dot4f(vec4f _a, vec4f _b) { return _a.x * _b.x + _a.y * _b.y + _a.z * _b.z + _a.w * _b.w; }
 
 /* magnitudes */
-double mag2f(vec2f _v) { return sqrt(_v.x * _v.x + _v.y * _v.y); }
-double mag3f(vec3f _v) { return sqrt(_v.x * _v.x + _v.y * _v.y + _v.z * _v.z); }
-double mag4f(vec4f _v) { return sqrt(_v.x * _v.x + _v.y * _v.y + _v.z * _v.z + _v.w * _v.w); }
+real mag2f(vec2f _v) { return sqrt(_v.x * _v.x + _v.y * _v.y); }
+real mag3f(vec3f _v) { return sqrt(_v.x * _v.x + _v.y * _v.y + _v.z * _v.z); }
+real mag4f(vec4f _v) { return sqrt(_v.x * _v.x + _v.y * _v.y + _v.z * _v.z + _v.w * _v.w); }
 
 /* normalise */
 vec2f norm2f(vec2f _v) {
-	double mag = FISQRT(_v.x * _v.x + _v.y * _v.y);
+	real mag = RSQRT(_v.x * _v.x + _v.y * _v.y);
 	return (vec2f) {_v.x * mag, _v.y * mag};
 }
 
 vec3f norm3f(vec3f _v) {
-	double mag = FISQRT(_v.x * _v.x + _v.y * _v.y + _v.z * _v.z);
+	real mag = RSQRT(_v.x * _v.x + _v.y * _v.y + _v.z * _v.z);
 	return (vec3f) {_v.x * mag, _v.y * mag, _v.z * mag};
 }
 
 vec4f norm4f(vec4f _v) {
-	double mag = FISQRT(_v.x * _v.x + _v.y * _v.y + _v.z * _v.z + _v.w * _v.w);
+	real mag = RSQRT(_v.x * _v.x + _v.y * _v.y + _v.z * _v.z + _v.w * _v.w);
 	return (vec4f) {_v.x * mag, _v.y * mag, _v.z * mag, _v.w * mag};
 }
 
 // quaternions
 
-typedef struct { double r, i, j, k; } qtrn;
+typedef struct { real r, i, j, k; } qtrn;
 typedef qtrn quat;
 
 /* quaternion multiplication (a.k.a. the hamilton product) */
@@ -189,9 +347,9 @@ qtrn qmul(qtrn _a, qtrn _b) {
 
 /* returns a rotation quaternion representing a rotaion of
  * `_phi` degrees about the axis defined by `_v` */
-qtrn make_qrot(vec3f _v, double _phi) {
-	double sin_phi = sin(_phi * 0.5);
-	double cos_phi = cos(_phi * 0.5);
+qtrn make_qrot(vec3f _v, real _phi) {
+	real sin_phi, cos_phi;
+	SINCOS(_phi * 0.5, &sin_phi, &cos_phi);
 	
 	return (qtrn) {
 		cos_phi,
@@ -201,9 +359,18 @@ qtrn make_qrot(vec3f _v, double _phi) {
 	};
 }
 
-/* rotates a vector `_p` by conjugation with the rotation
- * quaternion `_q` */
+/* rotates a vector `_p` by the rotation quaternion `_q`. this is the
+ * conjugation `q * p * q^-1` of `qrot_ref` expanded for a pure vector and a
+ * unit quaternion: with t = 2 (u x p), p' = p + r t + u x t. */
 vec3f qrot(qtrn _q, vec3f _p) {
+	vec3f u = {_q.i, _q.j, _q.k};
+	vec3f t = mul3f(cross3f(u, _p), 2);
+	return add3f(add3f(_p, mul3f(t, _q.r)), cross3f(u, t));
+}
+
+/* rotates a vector `_p` by conjugation with the rotation quaternion `_q`
+ * (reference for `qrot`) */
+vec3f qrot_ref(qtrn _q, vec3f _p) {
 	qtrn q_inv = (qtrn) {_q.r, -_q.i, -_q.j, -_q.k};
 	qtrn p = (qtrn) {0, _p.x, _p.y, _p.z};
 	p = qmul(qmul(_q, p), q_inv);
@@ -213,11 +380,12 @@ vec3f qrot(qtrn _q, vec3f _p) {
 
 // matrices
 
-typedef struct { double get[16];    } mat4f;
-typedef struct { double get[9];     } mat3f;
-typedef struct { double get[4];     } mat2f;
+typedef struct { real get[16];    } mat4f;
+typedef struct { real get[9];     } mat3f;
+typedef struct { real get[4];     } mat2f;
 
-vec4f mmul_vec4f(mat4f* _m, vec4f _v) {
+/* reference for `mmul_vec4f` (see linalg_simd.h) */
+vec4f mmul_vec4f_ref(mat4f* _m, vec4f _v) {
 	return (vec4f) {
 		_m->get[0 ] * _v.x + _m->get[1 ] * _v.y + _m->get[2 ] * _v.z + _m->get[3 ] * _v.w,
 		_m->get[4 ] * _v.x + _m->get[5 ] * _v.y + _m->get[6 ] * _v.z + _m->get[7 ] * _v.w,
@@ -265,7 +433,8 @@ mat2f mT2f(mat2f _m) {
 	}};
 }
 
-void mmul4f(mat4f* _r, mat4f* _a, mat4f* _b) {
+/* reference for `mmul4f` (see linalg_simd.h) */
+void mmul4f_ref(mat4f* _r, mat4f* _a, mat4f* _b) {
 	*_r = (mat4f) {{
 		_a->get[0] * _b->get[0 ] + _a->get[4] * _b->get[1 ] + _a->get[8 ] * _b->get[2 ] + _a->get[12] * _b->get[3 ],
 		_a->get[1] * _b->get[0 ] + _a->get[5] * _b->get[1 ] + _a->get[9 ] * _b->get[2 ] + _a->get[13] * _b->get[3 ],
@@ -286,4 +455,71 @@ void mmul4f(mat4f* _r, mat4f* _a, mat4f* _b) {
 	}};
 }
 
+// dense matrices (row major arrays, for sizes only known at run time)
+
+/* `_r` (m x m) = `_a` (m x n) times its transpose */
+void dense_aat(real* _r, real* _a, int _m, int _n) {
+	for (int i = 0; i < _m; i++) {
+		for (int j = 0; j <= i; j++) {
+			real sum = 0;
+			for (int k = 0; k < _n; k++) sum += _a[i * _n + k] * _a[j * _n + k];
+			_r[i * _m + j] = _r[j * _m + i] = sum;
+		}
+	}
+}
+
+/* `_r` (m) = `_a` (m x n) times `_v` (n) */
+void dense_av(real* _r, real* _a, real* _v, int _m, int _n) {
+	for (int i = 0; i < _m; i++) {
+		real sum = 0;
+		for (int k = 0; k < _n; k++) sum += _a[i * _n + k] * _v[k];
+		_r[i] = sum;
+	}
+}
+
+/* `_r` (n) = transpose of `_a` (m x n) times `_v` (m) */
+void dense_atv(real* _r, real* _a, real* _v, int _m, int _n) {
+	for (int k = 0; k < _n; k++) _r[k] = 0;
+	
+	for (int i = 0; i < _m; i++)
+		for (int k = 0; k < _n; k++) _r[k] += _a[i * _n + k] * _v[i];
+}
+
+/* in place cholesky factorisation of the symmetric positive definite `_a`
+ * (n x n), the factor L is left in the lower triangle.
+ * (returns -1 if `_a` is not positive definite) */
+int dense_cholesky(real* _a, int _n) {
+	for (int j = 0; j < _n; j++) {
+		real d = _a[j * _n + j];
+		for (int k = 0; k < j; k++) d -= _a[j * _n + k] * _a[j * _n + k];
+		if (d <= 0) return -1;
+		
+		d = _a[j * _n + j] = sqrt(d);
+		
+		for (int i = j + 1; i < _n; i++) {
+			real sum = _a[i * _n + j];
+			for (int k = 0; k < j; k++) sum -= _a[i * _n + k] * _a[j * _n + k];
+			_a[i * _n + j] = sum / d;
+		}
+	}
+	
+	return 0;
+}
+
+/* solves `L * L^T * x = _b` in place, `_l` being the output of
+ * `dense_cholesky` (n x n) */
+void dense_cholesky_solve(real* _l, real* _b, int _n) {
+	for (int i = 0; i < _n; i++) {
+		for (int k = 0; k < i; k++) _b[i] -= _l[i * _n + k] * _b[k];
+		_b[i] /= _l[i * _n + i];
+	}
+	
+	for (int i = _n - 1; i >= 0; i--) {
+		for (int k = i + 1; k < _n; k++) _b[i] -= _l[k * _n + i] * _b[k];
+		_b[i] /= _l[i * _n + i];
+	}
+}
+
+#include "linalg_simd.h"
+
 #endif
\ No newline at end of file
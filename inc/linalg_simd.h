@@ -0,0 +1,549 @@
+#ifndef __CRD_LINEAR_ALGEBRA_SIMD_H__
+#define __CRD_LINEAR_ALGEBRA_SIMD_H__
+
+/* batched vector and quaternion helpers, and the 4x4 matrix products. each
+ * one runs an AVX2 path when the cpu has it and falls back to the `_ref`
+ * version (plain loops over the scalar helpers in linalg.h) otherwise, the
+ * `_ref` versions are also what the vector paths are checked against.
+ *
+ * the `_n` functions work on arrays of `vec3f` (the output may be the input),
+ * the `_soa` ones on separate x, y and z arrays. */
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define LINALG_X86
+#endif
+
+/* whether the AVX2 paths are used on this machine (never in deterministic
+ * builds, their results depend on the machine) */
+int linalg_has_avx2(void) {
+	static int has = -1;
+	if (has != -1) return has;
+	
+	has = 0;
+	#if defined(LINALG_X86) && !defined(LINALG_DETERMINISTIC)
+		__builtin_cpu_init();
+		has = __builtin_cpu_supports("avx2");
+	#endif
+	
+	return has;
+}
+
+// scalar references
+
+void qrot_n_ref(qtrn _q, vec3f* _out, vec3f* _in, int _n) {
+	for (int i = 0; i < _n; i++) _out[i] = qrot(_q, _in[i]);
+}
+
+void norm3f_n_ref(vec3f* _out, vec3f* _in, int _n) {
+	for (int i = 0; i < _n; i++) _out[i] = norm3f(_in[i]);
+}
+
+void dot3f_n_ref(real* _out, vec3f* _a, vec3f* _b, int _n) {
+	for (int i = 0; i < _n; i++) _out[i] = dot3f(_a[i], _b[i]);
+}
+
+void cross3f_n_ref(vec3f* _out, vec3f* _a, vec3f* _b, int _n) {
+	for (int i = 0; i < _n; i++) _out[i] = cross3f(_a[i], _b[i]);
+}
+
+void qrot_soa_ref(qtrn _q, real* _x, real* _y, real* _z, int _n) {
+	for (int i = 0; i < _n; i++) {
+		vec3f v = qrot(_q, (vec3f) {_x[i], _y[i], _z[i]});
+		_x[i] = v.x, _y[i] = v.y, _z[i] = v.z;
+	}
+}
+
+void norm3f_soa_ref(real* _x, real* _y, real* _z, int _n) {
+	for (int i = 0; i < _n; i++) {
+		vec3f v = norm3f((vec3f) {_x[i], _y[i], _z[i]});
+		_x[i] = v.x, _y[i] = v.y, _z[i] = v.z;
+	}
+}
+
+void rsqrt_n_ref(real* _out, real* _in, int _n) {
+	for (int i = 0; i < _n; i++) _out[i] = RSQRT(_in[i]);
+}
+
+void acos_n_ref(real* _out, real* _in, int _n) {
+	for (int i = 0; i < _n; i++) _out[i] = ACOS(_in[i]);
+}
+
+void sincos_n_ref(real* _sin, real* _cos, real* _in, int _n) {
+	for (int i = 0; i < _n; i++) SINCOS(_in[i], &_sin[i], &_cos[i]);
+}
+
+// AVX2
+
+#ifdef LINALG_X86
+	#define LINALG_AVX2 __attribute__((target("avx2")))
+	
+	#ifdef LINALG_FLOAT
+		#define LV __m256
+		#define LV_W 8
+		#define LV_LD _mm256_loadu_ps
+		#define LV_ST _mm256_storeu_ps
+		#define LV_SET1 _mm256_set1_ps
+		#define LV_SET1I _mm256_set1_epi32
+		#define LV_ADD _mm256_add_ps
+		#define LV_SUB _mm256_sub_ps
+		#define LV_MUL _mm256_mul_ps
+		#define LV_DIV _mm256_div_ps
+		#define LV_SQRT _mm256_sqrt_ps
+		#define LV_FLOOR _mm256_floor_ps
+		#define LV_ROUND(A) _mm256_round_ps(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+		#define LV_LT(A, B) _mm256_cmp_ps(A, B, _CMP_LT_OQ)
+		#define LV_EQ(A, B) _mm256_cmp_ps(A, B, _CMP_EQ_OQ)
+		#define LV_OR _mm256_or_ps
+		#define LV_SEL(A, B, M) _mm256_blendv_ps(A, B, M)
+		#define LV_AS_I _mm256_castps_si256
+		#define LI_AS_V _mm256_castsi256_ps
+		#define LV_SRLI _mm256_srli_epi32
+		#define LV_SUBI _mm256_sub_epi32
+	#else
+		#define LV __m256d
+		#define LV_W 4
+		#define LV_LD _mm256_loadu_pd
+		#define LV_ST _mm256_storeu_pd
+		#define LV_SET1 _mm256_set1_pd
+		#define LV_SET1I _mm256_set1_epi64x
+		#define LV_ADD _mm256_add_pd
+		#define LV_SUB _mm256_sub_pd
+		#define LV_MUL _mm256_mul_pd
+		#define LV_DIV _mm256_div_pd
+		#define LV_SQRT _mm256_sqrt_pd
+		#define LV_FLOOR _mm256_floor_pd
+		#define LV_ROUND(A) _mm256_round_pd(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+		#define LV_LT(A, B) _mm256_cmp_pd(A, B, _CMP_LT_OQ)
+		#define LV_EQ(A, B) _mm256_cmp_pd(A, B, _CMP_EQ_OQ)
+		#define LV_OR _mm256_or_pd
+		#define LV_SEL(A, B, M) _mm256_blendv_pd(A, B, M)
+		#define LV_AS_I _mm256_castpd_si256
+		#define LI_AS_V _mm256_castsi256_pd
+		#define LV_SRLI _mm256_srli_epi64
+		#define LV_SUBI _mm256_sub_epi64
+	#endif
+	
+	/* lane-wise `RSQRT` (same math tier, initial guess and newton steps, so
+	 * the same bits) */
+	static inline LINALG_AVX2 LV __linalg_rsqrt(LV _x) {
+		#if LINALG_MATH_TIER == LINALG_EXACT
+			return LV_DIV(LV_SET1(1), LV_SQRT(_x));
+		#else
+			LV u = LI_AS_V(LV_SUBI(LV_SET1I(REAL_ISQRT_MAGIC), LV_SRLI(LV_AS_I(_x), 1)));
+			LV half_x = LV_MUL(LV_SET1(0.5), _x);
+			u = LV_MUL(u, LV_SUB(LV_SET1(1.5), LV_MUL(LV_MUL(half_x, u), u)));
+			#if LINALG_MATH_TIER != LINALG_FASTEST
+				u = LV_MUL(u, LV_SUB(LV_SET1(1.5), LV_MUL(LV_MUL(half_x, u), u)));
+			#endif
+			return u;
+		#endif
+	}
+	
+	/* `qrot` on `LV_W` vectors held in x, y and z registers */
+	static inline LINALG_AVX2 void __linalg_qrot(qtrn _q, LV* _x, LV* _y, LV* _z) {
+		LV r = LV_SET1(_q.r), i = LV_SET1(_q.i), j = LV_SET1(_q.j), k = LV_SET1(_q.k);
+		LV two = LV_SET1(2);
+		
+		// t = 2 (u x p)
+		LV tx = LV_MUL(two, LV_SUB(LV_MUL(j, *_z), LV_MUL(k, *_y)));
+		LV ty = LV_MUL(two, LV_SUB(LV_MUL(k, *_x), LV_MUL(i, *_z)));
+		LV tz = LV_MUL(two, LV_SUB(LV_MUL(i, *_y), LV_MUL(j, *_x)));
+		
+		// p + r t + u x t
+		*_x = LV_ADD(LV_ADD(*_x, LV_MUL(r, tx)), LV_SUB(LV_MUL(j, tz), LV_MUL(k, ty)));
+		*_y = LV_ADD(LV_ADD(*_y, LV_MUL(r, ty)), LV_SUB(LV_MUL(k, tx), LV_MUL(i, tz)));
+		*_z = LV_ADD(LV_ADD(*_z, LV_MUL(r, tz)), LV_SUB(LV_MUL(i, ty), LV_MUL(j, tx)));
+	}
+	
+	static inline LINALG_AVX2 void __linalg_norm(LV* _x, LV* _y, LV* _z) {
+		LV d = LV_ADD(LV_ADD(LV_MUL(*_x, *_x), LV_MUL(*_y, *_y)), LV_MUL(*_z, *_z));
+		LV s = __linalg_rsqrt(d);
+		*_x = LV_MUL(*_x, s);
+		*_y = LV_MUL(*_y, s);
+		*_z = LV_MUL(*_z, s);
+	}
+	
+	/* arrays of `vec3f` are transposed `LV_W` vectors at a time through these
+	 * (they stay in L1, so this costs little next to the arithmetic) */
+	#define LINALG_GATHER(V, X, Y, Z) \
+		real X##_[LV_W], Y##_[LV_W], Z##_[LV_W]; \
+		for (int l = 0; l < LV_W; l++) X##_[l] = (V)[l].x, Y##_[l] = (V)[l].y, Z##_[l] = (V)[l].z; \
+		LV X = LV_LD(X##_), Y = LV_LD(Y##_), Z = LV_LD(Z##_);
+	
+	#define LINALG_SCATTER(V, X, Y, Z) { \
+		real x_[LV_W], y_[LV_W], z_[LV_W]; \
+		LV_ST(x_, X); LV_ST(y_, Y); LV_ST(z_, Z); \
+		for (int l = 0; l < LV_W; l++) (V)[l] = (vec3f) {x_[l], y_[l], z_[l]}; \
+	}
+	
+	LINALG_AVX2 void __linalg_qrot_n_avx2(qtrn _q, vec3f* _out, vec3f* _in, int _n) {
+		int i = 0;
+		for (; i + LV_W <= _n; i += LV_W) {
+			LINALG_GATHER(&_in[i], x, y, z);
+			__linalg_qrot(_q, &x, &y, &z);
+			LINALG_SCATTER(&_out[i], x, y, z);
+		}
+		
+		qrot_n_ref(_q, &_out[i], &_in[i], _n - i);
+	}
+	
+	LINALG_AVX2 void __linalg_norm3f_n_avx2(vec3f* _out, vec3f* _in, int _n) {
+		int i = 0;
+		for (; i + LV_W <= _n; i += LV_W) {
+			LINALG_GATHER(&_in[i], x, y, z);
+			__linalg_norm(&x, &y, &z);
+			LINALG_SCATTER(&_out[i], x, y, z);
+		}
+		
+		norm3f_n_ref(&_out[i], &_in[i], _n - i);
+	}
+	
+	LINALG_AVX2 void __linalg_dot3f_n_avx2(real* _out, vec3f* _a, vec3f* _b, int _n) {
+		int i = 0;
+		for (; i + LV_W <= _n; i += LV_W) {
+			LINALG_GATHER(&_a[i], ax, ay, az);
+			LINALG_GATHER(&_b[i], bx, by, bz);
+			LV_ST(&_out[i], LV_ADD(LV_ADD(LV_MUL(ax, bx), LV_MUL(ay, by)), LV_MUL(az, bz)));
+		}
+		
+		dot3f_n_ref(&_out[i], &_a[i], &_b[i], _n - i);
+	}
+	
+	LINALG_AVX2 void __linalg_cross3f_n_avx2(vec3f* _out, vec3f* _a, vec3f* _b, int _n) {
+		int i = 0;
+		for (; i + LV_W <= _n; i += LV_W) {
+			LINALG_GATHER(&_a[i], ax, ay, az);
+			LINALG_GATHER(&_b[i], bx, by, bz);
+			LV x = LV_SUB(LV_MUL(ay, bz), LV_MUL(az, by));
+			LV y = LV_SUB(LV_MUL(az, bx), LV_MUL(ax, bz));
+			LV z = LV_SUB(LV_MUL(ax, by), LV_MUL(ay, bx));
+			LINALG_SCATTER(&_out[i], x, y, z);
+		}
+		
+		cross3f_n_ref(&_out[i], &_a[i], &_b[i], _n - i);
+	}
+	
+	LINALG_AVX2 void __linalg_qrot_soa_avx2(qtrn _q, real* _x, real* _y, real* _z, int _n) {
+		int i = 0;
+		for (; i + LV_W <= _n; i += LV_W) {
+			LV x = LV_LD(&_x[i]), y = LV_LD(&_y[i]), z = LV_LD(&_z[i]);
+			__linalg_qrot(_q, &x, &y, &z);
+			LV_ST(&_x[i], x);
+			LV_ST(&_y[i], y);
+			LV_ST(&_z[i], z);
+		}
+		
+		qrot_soa_ref(_q, &_x[i], &_y[i], &_z[i], _n - i);
+	}
+	
+	LINALG_AVX2 void __linalg_norm3f_soa_avx2(real* _x, real* _y, real* _z, int _n) {
+		int i = 0;
+		for (; i + LV_W <= _n; i += LV_W) {
+			LV x = LV_LD(&_x[i]), y = LV_LD(&_y[i]), z = LV_LD(&_z[i]);
+			__linalg_norm(&x, &y, &z);
+			LV_ST(&_x[i], x);
+			LV_ST(&_y[i], y);
+			LV_ST(&_z[i], z);
+		}
+		
+		norm3f_soa_ref(&_x[i], &_y[i], &_z[i], _n - i);
+	}
+	
+	LINALG_AVX2 void __linalg_rsqrt_n_avx2(real* _out, real* _in, int _n) {
+		int i = 0;
+		for (; i + LV_W <= _n; i += LV_W) LV_ST(&_out[i], __linalg_rsqrt(LV_LD(&_in[i])));
+		
+		rsqrt_n_ref(&_out[i], &_in[i], _n - i);
+	}
+	
+	#if LINALG_MATH_TIER != LINALG_EXACT
+		/* lane-wise `acos_fast` / `acos_fastest` */
+		LINALG_AVX2 void __linalg_acos_n_avx2(real* _out, real* _in, int _n) {
+			int i = 0;
+			for (; i + LV_W <= _n; i += LV_W) {
+				LV x = LV_LD(&_in[i]);
+				LV neg = LV_LT(x, LV_SET1(0));
+				x = LV_SEL(x, LV_MUL(x, LV_SET1(-1)), neg);
+				
+				#if LINALG_MATH_TIER == LINALG_FASTEST
+					LV poly = LV_ADD(LV_MUL(LV_SET1(-0.1683), x), LV_SET1(1.5676));
+					LV ret = LV_MUL(poly, LV_SQRT(LV_SUB(LV_SET1(1), x)));
+					LV pi = LV_SET1(PI);
+				#else
+					LV poly = LV_ADD(LV_MUL(LV_SET1(-0.0187293), x), LV_SET1(0.0742610));
+					poly = LV_ADD(LV_MUL(poly, x), LV_SET1(-0.2121144));
+					poly = LV_ADD(LV_MUL(poly, x), LV_SET1(1.5707288));
+					LV ret = LV_MUL(poly, LV_SQRT(LV_SUB(LV_SET1(1.0000000001), x)));
+					LV pi = LV_SET1(3.14159265358979);
+				#endif
+				
+				LV_ST(&_out[i], LV_SEL(ret, LV_SUB(pi, ret), neg));
+			}
+			
+			acos_n_ref(&_out[i], &_in[i], _n - i);
+		}
+		
+		/* lane-wise `sincos_fast` / `sincos_fastest` */
+		LINALG_AVX2 void __linalg_sincos_n_avx2(real* _sin, real* _cos, real* _in, int _n) {
+			int i = 0;
+			for (; i + LV_W <= _n; i += LV_W) {
+				LV x = LV_LD(&_in[i]);
+				
+				// reduce to [-pi/4, pi/4], q is the quarter turn (0 to 3)
+				LV q = LV_ROUND(LV_MUL(x, LV_SET1(2 / PI)));
+				LV r = LV_SUB(x, LV_MUL(q, LV_SET1(PI / 2)));
+				q = LV_SUB(q, LV_MUL(LV_SET1(4), LV_FLOOR(LV_MUL(q, LV_SET1(0.25)))));
+				
+				LV r2 = LV_MUL(r, r);
+				#if LINALG_MATH_TIER == LINALG_FASTEST
+					LV s = LV_ADD(LV_SET1(-1.0 / 6), LV_MUL(r2, LV_SET1(1.0 / 120)));
+					LV c = LV_ADD(LV_SET1(1.0 / 24), LV_MUL(r2, LV_SET1(-1.0 / 720)));
+				#else
+					LV s = LV_ADD(LV_SET1(1.0 / 120), LV_MUL(r2, LV_SET1(-1.0 / 5040)));
+					s = LV_ADD(LV_SET1(-1.0 / 6), LV_MUL(r2, s));
+					LV c = LV_ADD(LV_SET1(-1.0 / 720), LV_MUL(r2, LV_SET1(1.0 / 40320)));
+					c = LV_ADD(LV_SET1(1.0 / 24), LV_MUL(r2, c));
+				#endif
+				s = LV_MUL(r, LV_ADD(LV_SET1(1), LV_MUL(r2, s)));
+				c = LV_ADD(LV_SET1(1), LV_MUL(r2, LV_ADD(LV_SET1(-0.5), LV_MUL(r2, c))));
+				
+				// same quadrant fix up as `__linalg_unquadrant`
+				LV q1 = LV_EQ(q, LV_SET1(1)), q2 = LV_EQ(q, LV_SET1(2)), q3 = LV_EQ(q, LV_SET1(3));
+				LV swap = LV_OR(q1, q3);
+				LV sn = LV_SEL(s, c, swap), cs = LV_SEL(c, s, swap);
+				sn = LV_SEL(sn, LV_MUL(sn, LV_SET1(-1)), LV_OR(q2, q3));
+				cs = LV_SEL(cs, LV_MUL(cs, LV_SET1(-1)), LV_OR(q1, q2));
+				
+				LV_ST(&_sin[i], sn);
+				LV_ST(&_cos[i], cs);
+			}
+			
+			sincos_n_ref(&_sin[i], &_cos[i], &_in[i], _n - i);
+		}
+	#endif
+	
+	/* the matrices are column major, so column j of a * b is the columns of
+	 * a weighted by the elements of column j of b. a column of doubles fills
+	 * an AVX register, a column of floats an SSE one. */
+	LINALG_AVX2 void __linalg_mmul4f_avx2(mat4f* _r, mat4f* _a, mat4f* _b) {
+		#ifdef LINALG_FLOAT
+			#define MV __m128
+			#define MV_LD _mm_loadu_ps
+			#define MV_ST _mm_storeu_ps
+			#define MV_SET1 _mm_set1_ps
+			#define MV_ADD _mm_add_ps
+			#define MV_MUL _mm_mul_ps
+		#else
+			#define MV __m256d
+			#define MV_LD _mm256_loadu_pd
+			#define MV_ST _mm256_storeu_pd
+			#define MV_SET1 _mm256_set1_pd
+			#define MV_ADD _mm256_add_pd
+			#define MV_MUL _mm256_mul_pd
+		#endif
+		
+		MV a0 = MV_LD(&_a->get[0]), a1 = MV_LD(&_a->get[4]), a2 = MV_LD(&_a->get[8]), a3 = MV_LD(&_a->get[12]);
+		MV r[4];
+		
+		// every column is computed before any is stored, `_r` may be `_a` or `_b`
+		for (int j = 0; j < 4; j++) {
+			real* b = &_b->get[4 * j];
+			r[j] = MV_ADD(
+				MV_ADD(MV_MUL(a0, MV_SET1(b[0])), MV_MUL(a1, MV_SET1(b[1]))),
+				MV_ADD(MV_MUL(a2, MV_SET1(b[2])), MV_MUL(a3, MV_SET1(b[3])))
+			);
+		}
+		
+		for (int j = 0; j < 4; j++) MV_ST(&_r->get[4 * j], r[j]);
+		
+		#undef MV
+		#undef MV_LD
+		#undef MV_ST
+		#undef MV_SET1
+		#undef MV_ADD
+		#undef MV_MUL
+	}
+	
+	/* `mmul_vec4f` treats the matrix as row major: each element of the result
+	 * is the dot product of a row with `_v` */
+	LINALG_AVX2 vec4f __linalg_mmul_vec4f_avx2(mat4f* _m, vec4f _v) {
+		vec4f r;
+		
+		#ifdef LINALG_FLOAT
+			// transpose the rows into columns, then weight them like `mmul4f`
+			__m128 c0 = _mm_loadu_ps(&_m->get[0]), c1 = _mm_loadu_ps(&_m->get[4]);
+			__m128 c2 = _mm_loadu_ps(&_m->get[8]), c3 = _mm_loadu_ps(&_m->get[12]);
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			
+			_mm_storeu_ps(&r.x, _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(_v.x)), _mm_mul_ps(c1, _mm_set1_ps(_v.y))),
+				_mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(_v.z)), _mm_mul_ps(c3, _mm_set1_ps(_v.w)))
+			));
+		#else
+			// multiply every row by `_v`, then sum the products of each row
+			__m256d v = _mm256_loadu_pd(&_v.x);
+			__m256d p0 = _mm256_mul_pd(_mm256_loadu_pd(&_m->get[0]), v);
+			__m256d p1 = _mm256_mul_pd(_mm256_loadu_pd(&_m->get[4]), v);
+			__m256d p2 = _mm256_mul_pd(_mm256_loadu_pd(&_m->get[8]), v);
+			__m256d p3 = _mm256_mul_pd(_mm256_loadu_pd(&_m->get[12]), v);
+			
+			// {p0[0]+p0[1], p1[0]+p1[1], p0[2]+p0[3], p1[2]+p1[3]} and the same for p2, p3
+			__m256d h01 = _mm256_hadd_pd(p0, p1);
+			__m256d h23 = _mm256_hadd_pd(p2, p3);
+			
+			_mm256_storeu_pd(&r.x, _mm256_add_pd(
+				_mm256_permute2f128_pd(h01, h23, 0x20),
+				_mm256_permute2f128_pd(h01, h23, 0x31)
+			));
+		#endif
+		
+		return r;
+	}
+	
+	#undef LINALG_GATHER
+	#undef LINALG_SCATTER
+	#undef LV
+	#undef LV_W
+	#undef LV_LD
+	#undef LV_ST
+	#undef LV_SET1
+	#undef LV_SET1I
+	#undef LV_ADD
+	#undef LV_SUB
+	#undef LV_MUL
+	#undef LV_DIV
+	#undef LV_SQRT
+	#undef LV_FLOOR
+	#undef LV_ROUND
+	#undef LV_LT
+	#undef LV_EQ
+	#undef LV_OR
+	#undef LV_SEL
+	#undef LV_AS_I
+	#undef LI_AS_V
+	#undef LV_SRLI
+	#undef LV_SUBI
+#endif
+
+// dispatch
+
+/* `RSQRT` of `_n` values */
+void rsqrt_n(real* _out, real* _in, int _n) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) {
+			__linalg_rsqrt_n_avx2(_out, _in, _n);
+			return;
+		}
+	#endif
+	rsqrt_n_ref(_out, _in, _n);
+}
+
+/* `ACOS` of `_n` values (libm has no vector acos, so the exact tier is
+ * always scalar) */
+void acos_n(real* _out, real* _in, int _n) {
+	#if defined(LINALG_X86) && LINALG_MATH_TIER != LINALG_EXACT
+		if (linalg_has_avx2()) {
+			__linalg_acos_n_avx2(_out, _in, _n);
+			return;
+		}
+	#endif
+	acos_n_ref(_out, _in, _n);
+}
+
+/* `SINCOS` of `_n` values (always scalar in the exact tier) */
+void sincos_n(real* _sin, real* _cos, real* _in, int _n) {
+	#if defined(LINALG_X86) && LINALG_MATH_TIER != LINALG_EXACT
+		if (linalg_has_avx2()) {
+			__linalg_sincos_n_avx2(_sin, _cos, _in, _n);
+			return;
+		}
+	#endif
+	sincos_n_ref(_sin, _cos, _in, _n);
+}
+
+/* `qrot` applied to `_n` vectors */
+void qrot_n(qtrn _q, vec3f* _out, vec3f* _in, int _n) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) {
+			__linalg_qrot_n_avx2(_q, _out, _in, _n);
+			return;
+		}
+	#endif
+	qrot_n_ref(_q, _out, _in, _n);
+}
+
+/* `norm3f` applied to `_n` vectors */
+void norm3f_n(vec3f* _out, vec3f* _in, int _n) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) {
+			__linalg_norm3f_n_avx2(_out, _in, _n);
+			return;
+		}
+	#endif
+	norm3f_n_ref(_out, _in, _n);
+}
+
+/* `dot3f` of `_n` pairs of vectors */
+void dot3f_n(real* _out, vec3f* _a, vec3f* _b, int _n) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) {
+			__linalg_dot3f_n_avx2(_out, _a, _b, _n);
+			return;
+		}
+	#endif
+	dot3f_n_ref(_out, _a, _b, _n);
+}
+
+/* `cross3f` of `_n` pairs of vectors */
+void cross3f_n(vec3f* _out, vec3f* _a, vec3f* _b, int _n) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) {
+			__linalg_cross3f_n_avx2(_out, _a, _b, _n);
+			return;
+		}
+	#endif
+	cross3f_n_ref(_out, _a, _b, _n);
+}
+
+/* `qrot` applied in place to `_n` vectors stored as separate x, y and z arrays */
+void qrot_soa(qtrn _q, real* _x, real* _y, real* _z, int _n) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) {
+			__linalg_qrot_soa_avx2(_q, _x, _y, _z, _n);
+			return;
+		}
+	#endif
+	qrot_soa_ref(_q, _x, _y, _z, _n);
+}
+
+/* `norm3f` applied in place to `_n` vectors stored as separate x, y and z arrays */
+void norm3f_soa(real* _x, real* _y, real* _z, int _n) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) {
+			__linalg_norm3f_soa_avx2(_x, _y, _z, _n);
+			return;
+		}
+	#endif
+	norm3f_soa_ref(_x, _y, _z, _n);
+}
+
+/* 4x4 matrix product, `_r` may be `_a` or `_b` */
+void mmul4f(mat4f* _r, mat4f* _a, mat4f* _b) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) {
+			__linalg_mmul4f_avx2(_r, _a, _b);
+			return;
+		}
+	#endif
+	mmul4f_ref(_r, _a, _b);
+}
+
+vec4f mmul_vec4f(mat4f* _m, vec4f _v) {
+	#ifdef LINALG_X86
+		if (linalg_has_avx2()) return __linalg_mmul_vec4f_avx2(_m, _v);
+	#endif
+	return mmul_vec4f_ref(_m, _v);
+}
+
+#endif
@@ -4,16 +4,17 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <string.h>
 #include <malloc.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
 
 #include <linux/fb.h>
+#include <linux/ioctl.h>
 #include <linux/mman.h>
 
-extern void* mmap(void*, size_t, int, int, int, off_t);
-extern void* munmap(void*, size_t);
-extern void* memset(void*, int, size_t);
-extern void* memcpy(void*, void*, size_t);
-
 extern int ioctl(int, unsigned long, ...) __THROW;
 
 #ifndef __BMAP_H__
@@ -29,15 +30,247 @@ char* fb_pbuf = 0;
 char* fb_sbuf = 0;
 struct fb_fix_screeninfo fb_finfo = {0};
 struct fb_var_screeninfo fb_vinfo = {0};
+struct fb_var_screeninfo fb_vinfo_saved = {0}; // as the device was before `fb_init`
 
-int fb_init(char* _fb_dev_path) {
-	// open framebuffer device for reading and writing
-	int fd = open(_fb_dev_path, O_RDWR | O_SYNC);
+// the secondary buffer is off-screen memory. in copy mode `fb_swap` copies
+// it into the mapped screen. in flip mode the screen is twice as tall as the
+// display, `fb_swap` copies it into the hidden half and pans onto that.
+// flipping resizes the console's virtual screen, so it has to be asked for.
+enum {FB_COPY, FB_FLIP};
+
+int fb_mode = FB_COPY; // mode to ask `fb_init` for, FB_FLIP falls back to FB_COPY
+int fb_fd = -1;
+int fb_page = 0; // half of the screen that is displayed (flip mode)
+int fb_vsync = 1; // cleared once the driver refuses FBIO_WAITFORVSYNC
+
+// the copies into the screen bypass the cache with streaming stores where
+// the cpu has them, the screen is only ever written so caching it just evicts
+// the solver's data. spans shorter than FB_STREAM_MIN bytes and clears are
+// written normally, tests/blit.c measured streaming slower for them. `fb_blit`
+// is picked on first use, set it beforehand to force a path.
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define FB_X86
+#endif
+
+enum {FB_BLIT_PLAIN, FB_BLIT_SSE2, FB_BLIT_AVX};
+
+#define FB_STREAM_MIN 1024 // 8 tiles
+
+int fb_blit = -1;
+
+/* internal function that picks `fb_blit` for this machine */
+int __fb_blit_level(void) {
+	if (fb_blit != -1) return fb_blit;
+	
+	fb_blit = FB_BLIT_PLAIN;
+	#ifdef FB_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("sse2")) fb_blit = FB_BLIT_SSE2;
+		if (__builtin_cpu_supports("avx")) fb_blit = FB_BLIT_AVX;
+	#endif
+	
+	return fb_blit;
+}
+
+#ifdef FB_X86
+	/* internal function that copies `_n` bytes with 16 byte streaming stores
+	 * (`_src` is null to clear), the unaligned ends are written normally */
+	__attribute__((target("sse2"))) void __fb_stream_sse2(char* _dst, char* _src, size_t _n) {
+		size_t head = -(uintptr_t) _dst & 15;
+		if (head > _n) head = _n;
+		if (_src) memcpy(_dst, _src, head);
+		else memset(_dst, 0, head);
+		
+		size_t i = head;
+		__m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= _n; i += 16)
+			_mm_stream_si128((__m128i*) (_dst + i), _src ? _mm_loadu_si128((__m128i*) (_src + i)) : zero);
+		
+		if (_src) memcpy(_dst + i, _src + i, _n - i);
+		else memset(_dst + i, 0, _n - i);
+	}
+	
+	/* same with 32 byte streaming stores */
+	__attribute__((target("avx"))) void __fb_stream_avx(char* _dst, char* _src, size_t _n) {
+		size_t head = -(uintptr_t) _dst & 31;
+		if (head > _n) head = _n;
+		if (_src) memcpy(_dst, _src, head);
+		else memset(_dst, 0, head);
+		
+		size_t i = head;
+		__m256i zero = _mm256_setzero_si256();
+		for (; i + 32 <= _n; i += 32)
+			_mm256_stream_si256((__m256i*) (_dst + i), _src ? _mm256_loadu_si256((__m256i*) (_src + i)) : zero);
+		
+		if (_src) memcpy(_dst + i, _src + i, _n - i);
+		else memset(_dst + i, 0, _n - i);
+	}
+#endif
+
+/* copies `_n` bytes from `_src` to `_dst` (clears them if `_src` is null),
+ * around the cache if there are at least FB_STREAM_MIN of them. call
+ * `fb_blit_fence` once done with a batch. */
+void fb_blit_row(char* _dst, char* _src, size_t _n) {
+	if (_src && _n >= FB_STREAM_MIN) switch (__fb_blit_level()) {
+		#ifdef FB_X86
+			case FB_BLIT_AVX: __fb_stream_avx(_dst, _src, _n); return;
+			case FB_BLIT_SSE2: __fb_stream_sse2(_dst, _src, _n); return;
+		#endif
+	}
+	
+	if (_src) memcpy(_dst, _src, _n);
+	else memset(_dst, 0, _n);
+}
+
+/* orders the streaming stores of `fb_blit_row` before whatever comes next */
+void fb_blit_fence(void) {
+	#ifdef FB_X86
+		if (__fb_blit_level() != FB_BLIT_PLAIN) _mm_sfence();
+	#endif
+}
+
+// damage tracking. the screen is split into FB_TILE x FB_TILE pixel tiles,
+// the drawing functions of inc/lfb2d.h mark the tiles they draw to and
+// `fb_swap` only copies and clears those (and the ones that were displayed
+// until now, which have to be blanked). code that writes to `sbuf` directly
+// must mark its tiles itself, or call `fb_damage_all`.
+#define FB_TILE_SHIFT 5
+#define FB_TILE (1 << FB_TILE_SHIFT)
+
+int fb_tiles_x = 0;
+int fb_tiles_y = 0;
+uint8_t* fb_damage = 0; // tiles of the secondary buffer that may not be blank
+uint8_t* fb_shown = 0; // tiles of the displayed buffer that may not be blank
+uint8_t* fb_hidden = 0; // tiles of the hidden page that may not be blank (flip mode)
+
+/* internal function that allocates the tile maps, the screen is assumed to
+ * hold anything at first */
+int __fb_init_tiles(void) {
+	fb_tiles_x = (fb_vinfo.xres + FB_TILE - 1) >> FB_TILE_SHIFT;
+	fb_tiles_y = (fb_vinfo.yres + FB_TILE - 1) >> FB_TILE_SHIFT;
+	
+	fb_damage = calloc(fb_tiles_x * fb_tiles_y, 1);
+	fb_shown = malloc(fb_tiles_x * fb_tiles_y);
+	fb_hidden = malloc(fb_tiles_x * fb_tiles_y);
+	if (!fb_damage || !fb_shown || !fb_hidden) return -1;
+	
+	memset(fb_shown, 1, fb_tiles_x * fb_tiles_y);
+	memset(fb_hidden, 1, fb_tiles_x * fb_tiles_y);
+	return 0;
+}
+
+/* marks pixel (`_x`, `_y`) as drawn to (it must be on the screen) */
+static inline void fb_damage_point(int _x, int _y) {
+	fb_damage[(_y >> FB_TILE_SHIFT) * fb_tiles_x + (_x >> FB_TILE_SHIFT)] = 1;
+}
+
+/* marks the pixels from (`_x0`, `_y0`) to (`_x1`, `_y1`) inclusive as drawn
+ * to, clipped to the screen */
+void fb_damage_rect(int _x0, int _y0, int _x1, int _y1) {
+	if (_x0 < 0) _x0 = 0;
+	if (_y0 < 0) _y0 = 0;
+	if (_x1 >= (int) fb_vinfo.xres) _x1 = fb_vinfo.xres - 1;
+	if (_y1 >= (int) fb_vinfo.yres) _y1 = fb_vinfo.yres - 1;
+	
+	for (int ty = _y0 >> FB_TILE_SHIFT; ty <= _y1 >> FB_TILE_SHIFT; ty++)
+		for (int tx = _x0 >> FB_TILE_SHIFT; tx <= _x1 >> FB_TILE_SHIFT; tx++)
+			fb_damage[ty * fb_tiles_x + tx] = 1;
+}
+
+/* marks the whole secondary buffer as drawn to */
+void fb_damage_all(void) {
+	memset(fb_damage, 1, fb_tiles_x * fb_tiles_y);
+}
+
+/* internal function that copies the tiles set in `_a` or `_b` (may be null)
+ * from `_src` to `_dst`, or clears them in `_dst` if `_src` is null. runs of
+ * tiles along a row are handled as one span. `_screen` is set if `_dst` is
+ * the screen (written around the cache). */
+void __fb_tiles(uint8_t* _a, uint8_t* _b, char* _dst, char* _src, int _screen) {
+	for (int ty = 0; ty < fb_tiles_y; ty++) {
+		uint8_t* a = _a + ty * fb_tiles_x;
+		uint8_t* b = _b ? _b + ty * fb_tiles_x : a;
+		int y0 = ty << FB_TILE_SHIFT;
+		int y1 = y0 + FB_TILE < fb_vinfo.yres ? y0 + FB_TILE : fb_vinfo.yres;
+		
+		for (int tx = 0; tx < fb_tiles_x; tx++) {
+			if (!(a[tx] | b[tx])) continue;
+			
+			int end = tx + 1;
+			while (end < fb_tiles_x && (a[end] | b[end])) end++;
+			
+			size_t x0 = tx << FB_TILE_SHIFT;
+			size_t x1 = end << FB_TILE_SHIFT < fb_vinfo.xres ? end << FB_TILE_SHIFT : fb_vinfo.xres;
+			for (int y = y0; y < y1; y++) {
+				size_t off = y * fb_finfo.line_length + x0 * 4;
+				if (_screen) fb_blit_row(_dst + off, _src ? _src + off : 0, (x1 - x0) * 4);
+				else if (_src) memcpy(_dst + off, _src + off, (x1 - x0) * 4);
+				else memset(_dst + off, 0, (x1 - x0) * 4);
+			}
+			
+			tx = end;
+		}
+	}
+}
+
+/* internal function that points `pbuf` at the displayed page */
+void __fb_set_rows(void) {
+	char* front = fb_pbuf + fb_page * fb_vinfo.yres * fb_finfo.line_length;
+	
+	for (int y = 0; y < fb_vinfo.yres; y++)
+		pbuf[y] = (rgbx32*) (front + y * fb_finfo.line_length);
+}
+
+// backends. the screen comes from `fb_backend`, the framebuffer device by
+// default or plain memory (`fb_use_memory`) to run and profile the renderer
+// without a display. `open` fills in `fb_vinfo` and `fb_finfo` and maps
+// `fb_pbuf`, two pages tall if the backend can flip (`fb_mode` is left at
+// FB_FLIP then, and set to FB_COPY otherwise). `pan` displays page `yoffset`
+// and `shown` is told about every frame that was put on the screen.
+struct fb_backend {
+	int (*open)(char* _path); // 0 or one of the error codes of `fb_init`
+	void (*pan)(void);
+	void (*shown)(void); // may be null
+	void (*close)(void);
+};
+
+/* internal function that tries to switch to flip mode, leaving the screen
+ * as it was if the driver cannot hold or pan to a second page */
+int __fb_init_flip(void) {
+	struct fb_var_screeninfo vinfo = fb_vinfo;
+	
+	vinfo.yres_virtual = 2 * vinfo.yres;
+	if (ioctl(fb_fd, FBIOPUT_VSCREENINFO, &vinfo) == -1) return -1;
+	if (ioctl(fb_fd, FBIOGET_VSCREENINFO, &vinfo) == -1) return -1;
+	if (ioctl(fb_fd, FBIOGET_FSCREENINFO, &fb_finfo) == -1) return -1;
+	
+	vinfo.yoffset = vinfo.yres;
+	if (
+		vinfo.yres_virtual < 2 * vinfo.yres ||
+		fb_finfo.smem_len < 2 * vinfo.yres * fb_finfo.line_length ||
+		ioctl(fb_fd, FBIOPAN_DISPLAY, &vinfo) == -1
+	) {
+		ioctl(fb_fd, FBIOPUT_VSCREENINFO, &fb_vinfo);
+		ioctl(fb_fd, FBIOGET_FSCREENINFO, &fb_finfo);
+		return -1;
+	}
+	
+	vinfo.yoffset = 0;
+	ioctl(fb_fd, FBIOPAN_DISPLAY, &vinfo);
+	fb_vinfo = vinfo;
+	return 0;
+}
+
+int __fb_dev_open(char* _fb_dev_path) {
+	// open framebuffer device for reading and writing, kept open for panning
+	int fd = fb_fd = open(_fb_dev_path, O_RDWR | O_SYNC);
 	if (fd == -1) return 1;
 	
 	// retrieve variable and fixed screen information
 	if (ioctl(fd, FBIOGET_VSCREENINFO, &fb_vinfo) == -1) return 2;
 	if (ioctl(fd, FBIOGET_FSCREENINFO, &fb_finfo) == -1) return 2;
+	fb_vinfo_saved = fb_vinfo;
 	
 	// ensure visual part of framebuffer starts at top-left corner of screen
 	fb_vinfo.xoffset = 0;
@@ -50,39 +283,393 @@ int fb_init(char* _fb_dev_path) {
 	
 	if (fb_vinfo.nonstd) return 5;
 	
-	// map framebuffer to memory and map secondary buffer
+	if (fb_mode == FB_FLIP && __fb_init_flip() == -1) fb_mode = FB_COPY;
+	
+	// map framebuffer to memory
 	fb_pbuf = (char*) mmap(0, fb_finfo.smem_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-	fb_sbuf = (char*) mmap(0, fb_finfo.smem_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if (fb_pbuf == (char*) -1 || fb_sbuf == (char*) -1) return 6;
+	if (fb_pbuf == (char*) -1) return 6;
+	
+	return 0;
+}
+
+/* waits for the vertical blank if the driver can */
+void __fb_dev_pan(void) {
+	uint32_t crtc = 0;
+	
+	if (fb_vsync && ioctl(fb_fd, FBIO_WAITFORVSYNC, &crtc) == -1) fb_vsync = 0;
+	ioctl(fb_fd, FBIOPAN_DISPLAY, &fb_vinfo);
+}
+
+void __fb_dev_close(void) {
+	// give the console back its depth, virtual size and page
+	munmap(fb_pbuf, fb_finfo.smem_len);
+	ioctl(fb_fd, FBIOPUT_VSCREENINFO, &fb_vinfo_saved);
+	close(fb_fd);
+}
+
+struct fb_backend fb_device_backend = {__fb_dev_open, __fb_dev_pan, 0, __fb_dev_close};
+
+/* settings and statistics of the memory backend */
+struct fb_memory {
+	int xres;
+	int yres;
+	int line_length; // bytes per row, at least `xres * 4` (0 for exactly that)
+	char* dump; // printf pattern of the bitmaps frames are dumped to, or null
+	int dump_every; // dump every nth frame shown
+	unsigned long frames; // frames shown
+};
+
+struct fb_memory fb_memory = {1920, 1080, 0, 0, 1, 0};
+
+int __fb_mem_open(char* _path) {
+	int line_length = fb_memory.line_length ? fb_memory.line_length : fb_memory.xres * 4;
+	int pages = fb_mode == FB_FLIP ? 2 : 1;
+	
+	if (fb_memory.xres <= 0 || fb_memory.yres <= 0 || line_length < fb_memory.xres * 4) return 5;
+	
+	fb_vinfo = (struct fb_var_screeninfo) {0};
+	fb_vinfo.xres = fb_vinfo.xres_virtual = fb_memory.xres;
+	fb_vinfo.yres = fb_memory.yres;
+	fb_vinfo.yres_virtual = pages * fb_memory.yres;
+	fb_vinfo.bits_per_pixel = 32;
+	
+	fb_finfo = (struct fb_fix_screeninfo) {0};
+	fb_finfo.line_length = line_length;
+	fb_finfo.smem_len = pages * fb_memory.yres * line_length;
+	
+	fb_memory.frames = 0;
+	fb_pbuf = (char*) mmap(0, fb_finfo.smem_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (fb_pbuf == (char*) -1) return 6;
+	
+	return 0;
+}
+
+void __fb_mem_pan(void) {}
+
+#ifdef __BMAP_H__
+	int fb_export(char* _path);
+#endif
+
+void __fb_mem_shown(void) {
+	fb_memory.frames++;
+	
+	#ifdef __BMAP_H__
+		if (fb_memory.dump && fb_memory.frames % (fb_memory.dump_every > 0 ? fb_memory.dump_every : 1) == 0) {
+			char path[4096];
+			snprintf(path, sizeof(path), fb_memory.dump, fb_memory.frames);
+			fb_export(path);
+		}
+	#endif
+}
+
+void __fb_mem_close(void) {
+	munmap(fb_pbuf, fb_finfo.smem_len);
+}
+
+struct fb_backend fb_memory_backend = {__fb_mem_open, __fb_mem_pan, __fb_mem_shown, __fb_mem_close};
+
+struct fb_backend* fb_backend = &fb_device_backend;
+
+/* makes `fb_init` set up an off-screen `_xres` x `_yres` screen in memory
+ * with rows `_line_length` bytes apart (0 for `_xres * 4`). with `_dump` (a
+ * printf pattern taking the frame number, e.g. "frame%05lu.bmp") every
+ * frame put on the screen is written to a bitmap. */
+void fb_use_memory(int _xres, int _yres, int _line_length, char* _dump) {
+	fb_memory.xres = _xres;
+	fb_memory.yres = _yres;
+	fb_memory.line_length = _line_length;
+	fb_memory.dump = _dump;
+	fb_backend = &fb_memory_backend;
+}
+
+/* internal function that returns the page that is displayed */
+char* __fb_front(void) {
+	return fb_mode == FB_FLIP ? fb_pbuf + fb_page * fb_vinfo.yres * fb_finfo.line_length : fb_pbuf;
+}
+
+/* internal function that reports a frame put on the screen to the backend */
+void __fb_shown(void) {
+	if (fb_backend->shown) fb_backend->shown();
+}
+
+#ifdef __BMAP_H__
+	/* writes what is on the screen to the bitmap `_path` (the pixels are
+	 * written as they are, which is the byte order of 32 bit bitmaps on most
+	 * framebuffers). (returns -1 if the file cannot be written) */
+	int fb_export(char* _path) {
+		size_t width = fb_vinfo.xres * 4, size = width * fb_vinfo.yres;
+		char* front = __fb_front();
+		char* rows = front;
+		
+		// export_bitmap does not check that it could open the file
+		int fd = open(_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd == -1) return -1;
+		close(fd);
+		
+		// bitmaps have no row stride of their own
+		if (fb_finfo.line_length != width) {
+			if (!(rows = malloc(size))) return -1;
+			for (int y = 0; y < fb_vinfo.yres; y++)
+				memcpy(rows + y * width, front + y * fb_finfo.line_length, width);
+		}
+		
+		bitmap b = {0};
+		b.file_header = (struct BM_BITMAPFILEHEADER) {0x4D42, 14 + 40 + size, 0, 14 + 40};
+		b.info.length = 40;
+		b.info.width = fb_vinfo.xres;
+		b.info.height = -(int) fb_vinfo.yres; // top-down
+		b.info.num_planes = 1;
+		b.info.bpp = 32;
+		b.info.compression_method = BI_RGB;
+		b.info.image_size = size;
+		b.extra.padded_length = size;
+		b.rdata = (BYTE*) rows;
+		export_bitmap(_path, &b);
+		
+		if (rows != front) free(rows);
+		return 0;
+	}
+#endif
+
+int fb_init(char* _fb_dev_path) {
+	int err = fb_backend->open(_fb_dev_path);
+	if (err) return err;
+	
+	// map secondary buffer, the screen is only written to
+	fb_sbuf = (char*) mmap(0, fb_vinfo.yres * fb_finfo.line_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (fb_sbuf == (char*) -1) return 6;
 	
 	if ((sbuf = malloc(fb_vinfo.yres * sizeof(void*))) == (rgbx32**) -1
 	 || (pbuf = malloc(fb_vinfo.yres * sizeof(void*))) == (rgbx32**) -1) return 7;
 	
+	if (__fb_init_tiles() == -1) return 7;
+	
+	// both pages count as drawn to, the first frame blanks them
+	fb_page = 0;
+	__fb_set_rows();
 	for (int y = 0; y < fb_vinfo.yres; y++)
-		sbuf[y] = (rgbx32*) (fb_sbuf + y * fb_finfo.line_length),
-		pbuf[y] = (rgbx32*) (fb_pbuf + y * fb_finfo.line_length);
+		sbuf[y] = (rgbx32*) (fb_sbuf + y * fb_finfo.line_length);
 	
-	close(fd);
 	return 0;
 }
 
+void fb_async_stop(void);
+
 void fb_cleanup(void) {
-	munmap(fb_pbuf, fb_finfo.smem_len);
-	munmap(fb_sbuf, fb_finfo.smem_len);
+	fb_async_stop();
+	munmap(fb_sbuf, fb_vinfo.yres * fb_finfo.line_length);
+	fb_backend->close();
+}
+
+/* internal function that displays the hidden page (flip mode) */
+void __fb_pan(void) {
+	fb_vinfo.yoffset = (1 - fb_page) * fb_vinfo.yres;
+	fb_backend->pan();
+	fb_page = 1 - fb_page;
+	__fb_set_rows();
+}
+
+/* internal function that puts the off-screen buffer `_data`, blank outside
+ * the tiles set in `_damage`, on the screen. only tiles that were drawn to
+ * on either side are written, in flip mode into the hidden page before it
+ * is displayed. */
+void __fb_present(char* _data, uint8_t* _damage) {
+	int n = fb_tiles_x * fb_tiles_y;
+	
+	if (fb_mode == FB_FLIP) {
+		char* hidden = fb_pbuf + (1 - fb_page) * fb_vinfo.yres * fb_finfo.line_length;
+		__fb_tiles(_damage, fb_hidden, hidden, _data, 1);
+		memcpy(fb_hidden, _damage, n);
+		fb_blit_fence();
+		__fb_pan();
+		
+		uint8_t* tmp = fb_hidden;
+		fb_hidden = fb_shown;
+		fb_shown = tmp;
+	} else {
+		__fb_tiles(_damage, fb_shown, fb_pbuf, _data, 1);
+		memcpy(fb_shown, _damage, n);
+		fb_blit_fence();
+	}
+	
+	__fb_shown();
+}
+
+// asynchronous presenting. between `fb_async_start` and `fb_async_stop` the
+// secondary buffer is one of three off-screen buffers, `fb_swap` hands it to
+// a present thread and carries on drawing into another one while that thread
+// presents the newest finished buffer.
+// the buffers change hands through one atomic exchange of `ready` (triple
+// buffering), a frame the present thread had no time for is dropped.
+#define FB_FRESH 4 // set in `ready` until the buffer has been presented
+
+struct fb_buffer {
+	char* data;
+	rgbx32** rows;
+	uint8_t* damage; // tiles that may not be blank
+};
+
+struct fb_presenter {
+	struct fb_buffer bufs[3];
+	int back; // buffer being drawn to (render thread)
+	int front; // buffer last presented (present thread)
+	_Atomic int ready; // the third buffer, with FB_FRESH if not yet presented
+	rgbx32** sbuf; // secondary buffer of the synchronous mode
+	char* fb_sbuf;
+	uint8_t* fb_damage;
+	_Atomic int quit;
+	sem_t wake; // posted for every finished buffer
+	pthread_t thread;
+	unsigned long presented;
+	unsigned long dropped;
+	int running;
+};
+
+struct fb_presenter fb_async = {0};
+
+void* __fb_present_thread(void* _arg) {
+	while (!atomic_load_explicit(&fb_async.quit, memory_order_acquire)) {
+		sem_wait(&fb_async.wake);
+		if (!(atomic_load_explicit(&fb_async.ready, memory_order_acquire) & FB_FRESH)) continue;
+		
+		fb_async.front = atomic_exchange_explicit(&fb_async.ready, fb_async.front, memory_order_acq_rel) & ~FB_FRESH;
+		__fb_present(fb_async.bufs[fb_async.front].data, fb_async.bufs[fb_async.front].damage);
+		fb_async.presented++;
+	}
+	
+	return 0;
+}
+
+/* internal function that makes buffer `_b` the secondary buffer */
+void __fb_use_buffer(struct fb_buffer* _b) {
+	sbuf = _b->rows;
+	fb_sbuf = _b->data;
+	fb_damage = _b->damage;
+}
+
+/* internal function that hands the buffer drawn to over to the present
+ * thread and takes another one, cleared or (`_keep`) with the same contents */
+void __fb_async_swap(int _keep) {
+	struct fb_buffer* done = &fb_async.bufs[fb_async.back];
+	int n = fb_tiles_x * fb_tiles_y;
+	
+	int old = atomic_exchange_explicit(&fb_async.ready, fb_async.back | FB_FRESH, memory_order_acq_rel);
+	if (old & FB_FRESH) fb_async.dropped++;
+	fb_async.back = old & ~FB_FRESH;
+	sem_post(&fb_async.wake);
+	
+	// whatever the buffer held, presented or dropped, is only in its tiles
+	struct fb_buffer* b = &fb_async.bufs[fb_async.back];
+	__fb_tiles(b->damage, 0, b->data, 0, 0);
+	memset(b->damage, 0, n);
+	
+	if (_keep) {
+		__fb_tiles(done->damage, 0, b->data, done->data, 0);
+		memcpy(b->damage, done->damage, n);
+	}
+	
+	__fb_use_buffer(b);
+}
+
+/* internal function that releases the first `_n` off-screen buffers */
+void __fb_async_release(int _n) {
+	for (int i = 0; i < _n; i++) {
+		struct fb_buffer* b = &fb_async.bufs[i];
+		if (b->data != (char*) -1) munmap(b->data, fb_vinfo.yres * fb_finfo.line_length);
+		free(b->rows);
+		free(b->damage);
+		*b = (struct fb_buffer) {0};
+	}
+}
+
+/* starts presenting on a thread of its own (after `fb_init`). (returns -1 on
+ * error, with nothing left allocated) */
+int fb_async_start(void) {
+	size_t size = fb_vinfo.yres * fb_finfo.line_length;
+	int n = fb_tiles_x * fb_tiles_y;
+	
+	for (int i = 0; i < 3; i++) {
+		struct fb_buffer* b = &fb_async.bufs[i];
+		b->data = (char*) mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		b->rows = malloc(fb_vinfo.yres * sizeof(void*));
+		b->damage = calloc(n, 1);
+		if (b->data == (char*) -1 || !b->rows || !b->damage) {
+			__fb_async_release(i + 1);
+			return -1;
+		}
+		
+		for (int y = 0; y < fb_vinfo.yres; y++)
+			b->rows[y] = (rgbx32*) (b->data + y * fb_finfo.line_length);
+	}
+	
+	fb_async.sbuf = sbuf;
+	fb_async.fb_sbuf = fb_sbuf;
+	fb_async.fb_damage = fb_damage;
+	
+	fb_async.back = 0;
+	fb_async.front = 2;
+	atomic_store(&fb_async.ready, 1);
+	atomic_store(&fb_async.quit, 0);
+	fb_async.presented = fb_async.dropped = 0;
+	
+	if (sem_init(&fb_async.wake, 0, 0) == -1) {
+		__fb_async_release(3);
+		return -1;
+	}
+	
+	if (pthread_create(&fb_async.thread, 0, __fb_present_thread, 0)) {
+		sem_destroy(&fb_async.wake);
+		__fb_async_release(3);
+		return -1;
+	}
+	
+	__fb_use_buffer(&fb_async.bufs[0]);
+	fb_async.running = 1;
+	return 0;
+}
+
+/* presents the last buffer handed over, stops the present thread and goes
+ * back to presenting in `fb_swap` */
+void fb_async_stop(void) {
+	if (!fb_async.running) return;
+	
+	atomic_store_explicit(&fb_async.quit, 1, memory_order_release);
+	sem_post(&fb_async.wake);
+	pthread_join(fb_async.thread, 0);
+	sem_destroy(&fb_async.wake);
+	
+	int ready = atomic_load(&fb_async.ready);
+	if (ready & FB_FRESH) __fb_present(fb_async.bufs[ready & ~FB_FRESH].data, fb_async.bufs[ready & ~FB_FRESH].damage);
+	
+	sbuf = fb_async.sbuf;
+	fb_sbuf = fb_async.fb_sbuf;
+	fb_damage = fb_async.fb_damage;
+	
+	__fb_async_release(3);
+	fb_async.running = 0;
 }
 
 void fb_swap(void) {
-	// copy contents of secondary buffer to primary buffer
-	memcpy(fb_pbuf, fb_sbuf, fb_finfo.smem_len);
+	if (fb_async.running) {
+		__fb_async_swap(0);
+		return;
+	}
 	
-	// clear secondary buffer
-	for (int i = 0; i < fb_vinfo.yres; i++)
-		memset(fb_sbuf + i * fb_finfo.line_length, 0, fb_vinfo.xres * 4);
+	// put the secondary buffer on the screen and clear it where it was drawn
+	// to, it is about to be drawn to again so it stays cached
+	__fb_present(fb_sbuf, fb_damage);
+	__fb_tiles(fb_damage, 0, fb_sbuf, 0, 0);
+	memset(fb_damage, 0, fb_tiles_x * fb_tiles_y);
 }
 
 void fb_copy(void) {
-	// copy contents of secondary buffer to primary buffer
-	memcpy(fb_pbuf, fb_sbuf, fb_finfo.smem_len);
+	if (fb_async.running) {
+		__fb_async_swap(1);
+		return;
+	}
+	
+	// put the secondary buffer on the screen and keep drawing on top of it
+	__fb_present(fb_sbuf, fb_damage);
 }
 
 #endif
@@ -0,0 +1,299 @@
+#ifndef __CRD_THREAD_POOL_H__
+#define __CRD_THREAD_POOL_H__
+
+#include <time.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/* fixed size work-stealing thread pool. jobs are queued with `tp_submit`
+ * and run with `tp_wait`, once per frame:
+ *
+ *     tp_submit(&pool, fn, arg); ...
+ *     tp_wait(&pool);
+ *
+ * submitted jobs are dealt round-robin onto per-worker deques, each worker
+ * drains its own deque from the bottom and steals from the top of the
+ * others once it runs dry. every buffer is allocated in `tp_init`, so
+ * submitting and running jobs never allocates. */
+
+#define TP_EMPTY 0
+#define TP_OK 1
+#define TP_ABORT 2
+
+struct tp_job {
+	void (*fn)(void*);
+	void* arg;
+};
+
+/* chase-lev deque over a fixed ring of jobs (the capacity is a power of two) */
+struct tp_deque {
+	_Atomic long top;
+	_Atomic long bottom;
+	struct tp_job* jobs;
+	long mask;
+};
+
+/* per-worker statistics for the last frame */
+struct tp_stats {
+	uint64_t busy_ns; // time spent running jobs
+	uint32_t jobs; // jobs run
+	uint32_t steals; // jobs taken from another worker's deque
+};
+
+struct tp_worker {
+	struct tp_pool* pool;
+	int id;
+	pthread_t thread;
+	unsigned long frame; // last frame this worker took part in
+	struct tp_deque deque;
+	struct tp_stats stats;
+} __attribute__((aligned(64)));
+
+struct tp_pool {
+	struct tp_worker* workers;
+	int num_workers;
+	int next; // worker the next submitted job is dealt to
+	_Atomic long pending; // jobs of the current frame not yet finished
+	int active; // workers that have not yet finished the current frame
+	unsigned long frame;
+	int quit;
+	uint64_t frame_start;
+	uint64_t frame_ns; // wall time of the last frame
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+};
+
+static inline uint64_t __tp_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* pushes a job onto the bottom of the deque (owner only).
+ * (returns -1 if the deque is full) */
+int __tp_deque_push(struct tp_deque* _d, struct tp_job _job) {
+	long b = atomic_load_explicit(&_d->bottom, memory_order_relaxed);
+	long t = atomic_load_explicit(&_d->top, memory_order_acquire);
+	if (b - t > _d->mask) return -1;
+	
+	_d->jobs[b & _d->mask] = _job;
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&_d->bottom, b + 1, memory_order_relaxed);
+	return 0;
+}
+
+/* pops a job from the bottom of the deque (owner only) */
+int __tp_deque_pop(struct tp_deque* _d, struct tp_job* _job) {
+	long b = atomic_load_explicit(&_d->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&_d->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long t = atomic_load_explicit(&_d->top, memory_order_relaxed);
+	
+	if (t > b) {
+		atomic_store_explicit(&_d->bottom, b + 1, memory_order_relaxed);
+		return TP_EMPTY;
+	}
+	
+	*_job = _d->jobs[b & _d->mask];
+	if (t < b) return TP_OK;
+	
+	// last job left, race any thieves for it
+	int won = atomic_compare_exchange_strong_explicit(
+		&_d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed
+	);
+	atomic_store_explicit(&_d->bottom, b + 1, memory_order_relaxed);
+	return won ? TP_OK : TP_EMPTY;
+}
+
+/* takes a job from the top of the deque (any thread) */
+int __tp_deque_steal(struct tp_deque* _d, struct tp_job* _job) {
+	long t = atomic_load_explicit(&_d->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long b = atomic_load_explicit(&_d->bottom, memory_order_acquire);
+	if (t >= b) return TP_EMPTY;
+	
+	*_job = _d->jobs[t & _d->mask];
+	if (!atomic_compare_exchange_strong_explicit(
+		&_d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed
+	)) return TP_ABORT;
+	
+	return TP_OK;
+}
+
+void __tp_run_job(struct tp_worker* _w, struct tp_job _job) {
+	struct tp_pool* pool = _w->pool;
+	uint64_t t0 = __tp_now_ns();
+	_job.fn(_job.arg);
+	_w->stats.busy_ns += __tp_now_ns() - t0;
+	_w->stats.jobs++;
+	
+	if (atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_acq_rel) == 1)
+		pool->frame_ns = __tp_now_ns() - pool->frame_start;
+}
+
+/* tries to steal a job from every other worker in turn.
+ * (returns TP_EMPTY only once every deque was seen empty) */
+int __tp_steal_any(struct tp_worker* _w, struct tp_job* _job) {
+	struct tp_pool* pool = _w->pool;
+	int ret = TP_EMPTY;
+	
+	for (int i = 1; i < pool->num_workers; i++) {
+		struct tp_worker* victim = &pool->workers[(_w->id + i) % pool->num_workers];
+		switch (__tp_deque_steal(&victim->deque, _job)) {
+			case TP_OK: return TP_OK;
+			case TP_ABORT: ret = TP_ABORT;
+		}
+	}
+	
+	return ret;
+}
+
+void* __tp_worker_main(void* _arg) {
+	struct tp_worker* w = _arg;
+	struct tp_pool* pool = w->pool;
+	struct tp_job job;
+	
+	pthread_mutex_lock(&pool->lock);
+	
+	for (;;) {
+		// sleep until the next frame is started
+		while (w->frame == pool->frame && !pool->quit)
+			pthread_cond_wait(&pool->start, &pool->lock);
+		if (pool->quit) break;
+		w->frame = pool->frame;
+		pthread_mutex_unlock(&pool->lock);
+		
+		for (;;) {
+			if (__tp_deque_pop(&w->deque, &job) == TP_OK) {
+				__tp_run_job(w, job);
+				continue;
+			}
+			
+			int r = __tp_steal_any(w, &job);
+			if (r == TP_OK) {
+				w->stats.steals++;
+				__tp_run_job(w, job);
+			}
+			else if (r == TP_EMPTY) break;
+			else sched_yield();
+		}
+		
+		// the last worker out of the frame wakes up `tp_wait`
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->active == 0) pthread_cond_broadcast(&pool->done);
+	}
+	
+	pthread_mutex_unlock(&pool->lock);
+	return 0;
+}
+
+/* stops every worker and frees the pool */
+void tp_destroy(struct tp_pool* _pool) {
+	pthread_mutex_lock(&_pool->lock);
+	_pool->quit = 1;
+	pthread_cond_broadcast(&_pool->start);
+	pthread_mutex_unlock(&_pool->lock);
+	
+	for (int i = 0; i < _pool->num_workers; i++) {
+		pthread_join(_pool->workers[i].thread, 0);
+		free(_pool->workers[i].deque.jobs);
+	}
+	
+	pthread_mutex_destroy(&_pool->lock);
+	pthread_cond_destroy(&_pool->start);
+	pthread_cond_destroy(&_pool->done);
+	free(_pool->workers);
+	_pool->workers = 0;
+	_pool->num_workers = 0;
+}
+
+/* starts a pool of `_num_workers` threads (one per online cpu if
+ * `_num_workers` is not positive) able to queue `_max_jobs` jobs per frame.
+ * (returns -1 on error) */
+int tp_init(struct tp_pool* _pool, int _num_workers, int _max_jobs) {
+	if (_num_workers <= 0) _num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if (_num_workers <= 0) _num_workers = 1;
+	
+	// jobs are dealt round-robin, so no deque ever holds more than this
+	long capacity = 1;
+	while (capacity < (_max_jobs + _num_workers - 1) / _num_workers) capacity <<= 1;
+	
+	*_pool = (struct tp_pool) {0};
+	_pool->num_workers = _num_workers;
+	_pool->workers = aligned_alloc(64, _num_workers * sizeof(struct tp_worker));
+	if (!_pool->workers) return -1;
+	
+	pthread_mutex_init(&_pool->lock, 0);
+	pthread_cond_init(&_pool->start, 0);
+	pthread_cond_init(&_pool->done, 0);
+	
+	for (int i = 0; i < _num_workers; i++) {
+		struct tp_worker* w = &_pool->workers[i];
+		*w = (struct tp_worker) {.pool = _pool, .id = i};
+		w->deque.mask = capacity - 1;
+		w->deque.jobs = malloc(capacity * sizeof(struct tp_job));
+		if (!w->deque.jobs) {
+			_pool->num_workers = i;
+			tp_destroy(_pool);
+			return -1;
+		}
+		
+		if (pthread_create(&w->thread, 0, __tp_worker_main, w)) {
+			free(w->deque.jobs);
+			_pool->num_workers = i;
+			tp_destroy(_pool);
+			return -1;
+		}
+	}
+	
+	return 0;
+}
+
+/* queues `_fn(_arg)` for the next `tp_wait`. must only be called from the
+ * thread that calls `tp_wait`. (returns -1 if the queue is full) */
+int tp_submit(struct tp_pool* _pool, void (*_fn)(void*), void* _arg) {
+	struct tp_worker* w = &_pool->workers[_pool->next];
+	if (__tp_deque_push(&w->deque, (struct tp_job) {_fn, _arg}) == -1) return -1;
+	
+	_pool->next = (_pool->next + 1) % _pool->num_workers;
+	atomic_fetch_add_explicit(&_pool->pending, 1, memory_order_relaxed);
+	return 0;
+}
+
+/* runs every job submitted since the last call and blocks until they have
+ * all finished. */
+void tp_wait(struct tp_pool* _pool) {
+	pthread_mutex_lock(&_pool->lock);
+	
+	for (int i = 0; i < _pool->num_workers; i++)
+		_pool->workers[i].stats = (struct tp_stats) {0};
+	
+	_pool->next = 0;
+	_pool->frame_ns = 0;
+	
+	// every worker takes part in the frame (if only to find nothing to steal)
+	// so that no worker is still touching a deque once this returns
+	if (atomic_load(&_pool->pending) > 0) {
+		_pool->frame_start = __tp_now_ns();
+		_pool->active = _pool->num_workers;
+		_pool->frame++;
+		pthread_cond_broadcast(&_pool->start);
+		while (_pool->active > 0)
+			pthread_cond_wait(&_pool->done, &_pool->lock);
+	}
+	
+	pthread_mutex_unlock(&_pool->lock);
+}
+
+/* fraction of the last frame's wall time that worker `_i` spent running
+ * jobs (compare workers to spot imbalance) */
+double tp_utilisation(struct tp_pool* _pool, int _i) {
+	if (!_pool->frame_ns) return 0;
+	return (double) _pool->workers[_i].stats.busy_ns / _pool->frame_ns;
+}
+
+#endif
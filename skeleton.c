@@ -5,118 +5,276 @@ enum {ERROR_FAILED_ALLOCATE};
 
 #define XERR(MESG, ERRCODE) { perror(MESG"\n"); exit(ERRCODE); }
 
+/* `IK_DETERMINISTIC` makes every solver reproducible bit for bit across
+ * builds and machines (see `LINALG_DETERMINISTIC` and `make deterministic`),
+ * so that replays can be checked with `ik_chain_replay` hashes instead of
+ * sending whole poses. */
+#ifdef IK_DETERMINISTIC
+	#define LINALG_DETERMINISTIC
+#endif
+
 #include <math.h>
 #include "inc/bcl/bmap.c"
 #include "inc/linalg.h"
 #include "inc/linuxfb.h"
 #include "inc/lfb2d.h"
 #include "inc/mouse.h"
+#include "inc/thread_pool.h"
+#include "inc/arena.h"
+
+enum {IK_LIMIT_CONE, IK_LIMIT_ELLIPSE};
+
+/* joint limit of a bone relative to the bone before it (the chain's `rtn`
+ * for the root bone). a cone allows a swing of `aperture` in every direction,
+ * an ellipse allows `aperture` towards `up` and `aperture_y` across it (both
+ * strictly between 0 and PI/2). bones have no twist, so `up` is a world
+ * direction, it does not need to be orthogonal to the bone. the trigonometry
+ * of the apertures is cached by `ik_chain_update_limits`. the limits of a
+ * chain's nodes are kept next to them rather than in them, so that the nodes
+ * stay small (a whole pose is copied and stored as nodes). */
+struct ik_limit {
+	short type; // IK_LIMIT_CONE or IK_LIMIT_ELLIPSE
+	real aperture_y;
+	vec3f up;
+	real cos_ap, sin_ap; // of `aperture`
+	real cot_ap, cot_ap_y; // of `aperture` and `aperture_y`
+};
 
 struct ik_node {
-	double length;
-	double aperture;
+	real length;
+	real aperture;
 	vec3f pos;
 	vec3f rtn;
 };
 
 struct ik_chain {
 	struct ik_node* nodes;
+	struct ik_limit* limits; // limit of every node (node k's bone relative to its own)
 	short num_nodes;
-	double aperture;
+	real aperture;
 	vec3f rtn;
+	struct ik_limit limit;
+	vec3f last_target; // target of the last `ik_chain_solve_fabrik_warm`
+	short warm; // set while the pose is still the solution for `last_target`
+	qtrn* pending; // CCD scratch, room for `num_nodes` rotations (null in chains put together by hand)
+};
+
+/* solver settings, solvers stop at whichever limit is hit first */
+struct ik_solve_opts {
+	int max_iterations;
+	real tolerance; // distance between effector and target that counts as solved
+	real min_improvement; // smallest decrease in that distance worth another iteration
+};
+
+/* what a solver call did */
+struct ik_solve_result {
+	int iterations; // iterations actually run
+	real error; // final distance between effector and target
 };
 
+#define IK_FABRIK_DEFAULTS ((struct ik_solve_opts) {100, 0.001, 0.000001})
+#define IK_CCD_DEFAULTS ((struct ik_solve_opts) {10, 0.001, 0.000001})
+
+/* settings for solving a chain again every frame, see `ik_chain_solve_fabrik_warm` */
+struct ik_warm_opts {
+	real skip_distance; // target movement small enough to keep the last pose
+	struct ik_solve_opts cold; // used when there is no previous solution
+	struct ik_solve_opts warm; // used when starting from the previous solution
+};
+
+#define IK_WARM_DEFAULTS ((struct ik_warm_opts) {0.001, IK_FABRIK_DEFAULTS, {10, 0.001, 0.000001}})
+
 int ik_draw_chain(struct ik_chain* _chain, int, int);
+int ik_chain_solve(struct ik_chain* _chain, vec3f, struct ik_solve_opts*, struct ik_solve_result*);
+
+#include "inc/ik_fk.h"
+
+/* distance between the effector of a chain and `_target` */
+real ik_chain_error(struct ik_chain* _chain, vec3f _target) {
+	return mag3f(sub3f(_chain->nodes[0].pos, _target));
+}
 
 /* solves an inverse kinematics chain for the specified target using
- * the method of cyclic coordinate descent (CCD). (returns -1 on error) */
-int ik_chain_solve_ccd(struct ik_chain* _chain, vec3f _target, double _rigidity) {
+ * the method of cyclic coordinate descent (CCD). the rotations are applied
+ * through `struct ik_fk`, so an iteration is O(n) rather than O(n^2), with
+ * the chain's `pending` as scratch (allocated here if it is null).
+ * targets close to the full reach of the chain are only approached by a
+ * fraction of the remaining distance every iteration, so they can take
+ * hundreds (FABRIK closes in faster there, see `make bench_solvers`).
+ * `_opts` may be null to use `IK_CCD_DEFAULTS`, and `_res` may be null.
+ * (returns -1 on error, `_res` still gets the iterations run) */
+int ik_chain_solve_ccd(struct ik_chain* _chain, vec3f _target, real _rigidity, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
 	vec3f effector_vec; // vector from bone pivot to effector
 	vec3f target_vec; // vector from bone pivot to target
 	
-	double phi;
+	struct ik_solve_opts opts = _opts ? *_opts : IK_CCD_DEFAULTS;
+	real error = ik_chain_error(_chain, _target);
+	real phi;
+	int i, ret = 0;
 	
-	for (int i = 0; i < 10; i++) // number of CCD iterations
-	for (short k = 1; k < _chain->num_nodes; k++) {
-		effector_vec = sub3f(_chain->nodes[0].pos, _chain->nodes[k].pos);
-		target_vec = sub3f(_target, _chain->nodes[k].pos);
-		
-		// calculate rotation needed to face joint towards the target
-		double denom = (mag3f(effector_vec) * mag3f(target_vec));
-		double cos_phi = dot3f(effector_vec, target_vec) / denom;
-		
-		// return if `denom` is 0 (some node likely has a zero vector
-		// for its direction)
-		if (fabs(denom) < 0.0000000001) return -1;
-		
-		// prevent acos from giving nan and causing the entire code-
-		// base to spiral into chaos (even with 1.0000000000001).
-		if (cos_phi > 0.999999999) phi = 0;
-		else if (cos_phi < -0.999999999) phi = PI;
-		else phi = acos_that_actually_works(cos_phi);
-		
-		// smoothing coefficient
-		phi *= _rigidity;
-		
-		// rotate joint and update remaining chain
-		vec3f axis = norm3f(cross3f(effector_vec, target_vec));
-		qtrn rot = make_qrot(axis, phi);
+	qtrn* pending = _chain->pending ? _chain->pending : malloc(_chain->num_nodes * sizeof(qtrn));
+	if (!pending) return -1;
+	
+	struct ik_fk fk;
+	ik_fk_init(&fk, _chain, pending);
+	
+	for (i = 0; i < opts.max_iterations && error > opts.tolerance; ) {
+		for (short k = 1; k < _chain->num_nodes; k++) {
+			vec3f pivot = ik_fk_pos(&fk, k);
+			effector_vec = sub3f(fk.effector, pivot);
+			target_vec = sub3f(_target, pivot);
+			
+			// calculate rotation needed to face joint towards the target
+			real denom = (mag3f(effector_vec) * mag3f(target_vec));
+			real cos_phi = dot3f(effector_vec, target_vec) / denom;
+			
+			// fail if `denom` is 0 (some node likely has a zero vector
+			// for its direction)
+			if (fabs(denom) < 0.0000000001) {
+				ret = -1;
+				break;
+			}
+			
+			// prevent acos from giving nan and causing the entire code-
+			// base to spiral into chaos (even with 1.0000000000001). small
+			// angles come from the cross product instead, acos can not
+			// resolve them from their cosine and they still move the
+			// effector by the angle times its distance from the joint
+			vec3f normal = cross3f(effector_vec, target_vec);
+			if (cos_phi > 0.999999999) phi = mag3f(normal) / denom;
+			else if (cos_phi < -0.999999999) phi = PI;
+			else phi = ACOS(cos_phi);
+			
+			if (phi == 0) continue;
+			
+			// smoothing coefficient
+			phi *= _rigidity;
+			
+			// rotate joint, the remaining chain follows on the next flush
+			ik_fk_rotate(&fk, k, make_qrot(norm3f(normal), phi));
+		}
 		
-		_chain->nodes[k].rtn = norm3f(qrot(rot, _chain->nodes[k].rtn));
+		if (ret == -1) break;
 		
-		for (int n = k - 1; n >= 0; n--) {
-			_chain->nodes[n].rtn = norm3f(qrot(rot, _chain->nodes[n].rtn));
-			_chain->nodes[n].pos.x = _chain->nodes[n + 1].pos.x + _chain->nodes[n + 1].length * _chain->nodes[n + 1].rtn.x;
-			_chain->nodes[n].pos.y = _chain->nodes[n + 1].pos.y + _chain->nodes[n + 1].length * _chain->nodes[n + 1].rtn.y;
-			_chain->nodes[n].pos.z = _chain->nodes[n + 1].pos.z + _chain->nodes[n + 1].length * _chain->nodes[n + 1].rtn.z;
-		}
+		// stop early once an iteration no longer gets the effector closer
+		i++;
+		real last_error = error;
+		error = mag3f(sub3f(fk.effector, _target));
+		if (last_error - error < opts.min_improvement) break;
 	}
 	
-	return 0;
+	// the tracked effector can drift from the flushed one by rounding
+	ik_fk_flush(&fk);
+	if (_res) *_res = (struct ik_solve_result) {i, ik_chain_error(_chain, _target)};
+	
+	if (pending != _chain->pending) free(pending);
+	return ret;
+}
+
+/* internal function that returns a unit vector orthogonal to `_axis` in the
+ * plane of `_axis` and `_v` (on the side of `_v`), or any orthogonal one if
+ * they are parallel. (the double cross product stays orthogonal to `_axis`
+ * even when `_v` is almost opposite to it, unlike `_v - _axis * cos_phi`) */
+vec3f __ik_swing_dir(vec3f _axis, vec3f _v) {
+	vec3f perp = cross3f(cross3f(_axis, _v), _axis);
+	if (dot3f(perp, perp) > 0.000000000001) return norm3f(perp);
+	
+	perp = cross3f(_axis, fabs(_axis.x) < 0.9 ? (vec3f) {1, 0, 0} : (vec3f) {0, 1, 0});
+	return norm3f(perp);
 }
 
 /* internal function that clamps a vector to the inside of a cone: the cone's
  * axis is a vector from its tip to the centre of its base, and the cone's aperture
- * is the angle between its axis and its edge. (both vectors must be normalised) */
-vec3f __ik_clamp_vector_to_cone(vec3f _cone_axis, double _cone_aperture, vec3f _v) {
+ * is the angle between its axis and its edge, given by its cosine and sine.
+ * (both vectors must be normalised) */
+vec3f __ik_clamp_vector_to_cone(vec3f _cone_axis, real _cos_ap, real _sin_ap, vec3f _v) {
 		// we are assuming the provided vectors are normalised so the
 		// cosine of the angle between them is simply their dot product
-		double cos_phi = dot3f(_cone_axis, _v);
+		real cos_phi = dot3f(_cone_axis, _v);
 		
 		// if the angle between the cone axis and our vector is greater than
-		// the aperture of the cone then the vector needs to be clamped
-		if (acos(cos_phi) > _cone_aperture) {
-			// rotate the cone's axis to its edge about an axis orthogonal
-			// to both the axis of the cone and the vector we wish to clamp
-			// (with quaternions!)
-			vec3f axis = norm3f(cross3f(_cone_axis, _v));
-			qtrn q = make_qrot(axis, _cone_aperture);
-			return qrot(q, _cone_axis);
+		// the aperture of the cone (its cosine is smaller) then the vector
+		// needs to be clamped
+		if (cos_phi < _cos_ap) {
+			// the edge of the cone in the plane of the axis and the vector,
+			// which is the axis rotated by the aperture towards the vector
+			vec3f perp = __ik_swing_dir(_cone_axis, _v);
+			return add3f(mul3f(_cone_axis, _cos_ap), mul3f(perp, _sin_ap));
 		}
 		
 		// if the vector was not clamped, return it unchanged
 		return _v;
 }
 
+/* internal function that clamps a vector to the inside of an elliptical
+ * limit around `_axis`. projected onto the plane one unit along the axis
+ * (where a swing of angle a lands at distance tan(a)), the limit is an
+ * ellipse with semi axes tan(aperture) along `up` and tan(aperture_y) across
+ * it. vectors outside are pulled back towards the axis until they are on it.
+ * (both vectors must be normalised) */
+vec3f __ik_clamp_vector_to_ellipse(vec3f _axis, struct ik_limit* _limit, vec3f _v) {
+	// frame of the ellipse: u along `up`, w across it
+	vec3f u = __ik_swing_dir(_axis, _limit->up);
+	vec3f w = cross3f(_axis, u);
+	real a = dot3f(_v, u), b = dot3f(_v, w), c = dot3f(_v, _axis);
+	
+	// (a / c, b / c) is the projection, inside when
+	// (a / c / tan(ap))^2 + (b / c / tan(ap_y))^2 <= 1
+	real ea = a * _limit->cot_ap, eb = b * _limit->cot_ap_y;
+	real s = ea * ea + eb * eb;
+	if (c > 0 && s <= c * c) return _v;
+	
+	// straight behind the axis, any direction is as good as another
+	if (s < 0.000000000001) {
+		a = 1 / _limit->cot_ap;
+		b = 0;
+		s = 1;
+	}
+	
+	// scale the swing so that the projection lands on the ellipse
+	real k = RSQRT(s);
+	return norm3f(add3f(_axis, add3f(mul3f(u, a * k), mul3f(w, b * k))));
+}
+
+/* internal function that clamps a vector to a joint limit around `_axis`
+ * (both vectors must be normalised) */
+vec3f __ik_clamp_vector_to_limit(vec3f _axis, struct ik_limit* _limit, vec3f _v) {
+	if (_limit->type == IK_LIMIT_ELLIPSE) return __ik_clamp_vector_to_ellipse(_axis, _limit, _v);
+	return __ik_clamp_vector_to_cone(_axis, _limit->cos_ap, _limit->sin_ap, _v);
+}
+
+/* internal function that tells if a vector is within a joint limit around
+ * `_axis`, give or take `_slack` (both vectors must be normalised) */
+int __ik_within_limit(vec3f _axis, struct ik_limit* _limit, vec3f _v, real _slack) {
+	real c = dot3f(_v, _axis);
+	if (_limit->type != IK_LIMIT_ELLIPSE) return c >= _limit->cos_ap - _slack;
+	
+	vec3f u = __ik_swing_dir(_axis, _limit->up);
+	real ea = dot3f(_v, u) * _limit->cot_ap, eb = dot3f(_v, cross3f(_axis, u)) * _limit->cot_ap_y;
+	return c > 0 && ea * ea + eb * eb <= c * c + _slack;
+}
+
 /* solves an inverse kinematics chain for the specified target using
- * the method of forward and backward reaching inverse kinematics (FABRIK). */
-int ik_chain_solve_fabrik(struct ik_chain* _chain, vec3f _target) {
+ * the method of forward and backward reaching inverse kinematics (FABRIK).
+ * `_opts` may be null to use `IK_FABRIK_DEFAULTS`, and `_res` may be null. */
+int ik_chain_solve_fabrik(struct ik_chain* _chain, vec3f _target, struct ik_solve_opts* _opts, struct ik_solve_result* _res) {
 	vec3f target; // current target position (not always `_target`)
 	vec3f joint_vec; // vector from joint to current target
 	vec3f root = _chain->nodes[_chain->num_nodes - 1].pos; // root position of chain
 	
-	double cos_phi;
+	struct ik_solve_opts opts = _opts ? *_opts : IK_FABRIK_DEFAULTS;
+	real error = ik_chain_error(_chain, _target);
+	int k, i;
 	
-	// one hundred FABRIK iterations
-	for (int k, i = 0; i < 1; i++) {
+	for (i = 0; i < opts.max_iterations && error > opts.tolerance; ) {
 		///////////////////////////////////////////
 		// FORWARD PASS                          //
 		///////////////////////////////////////////
 		target = _chain->nodes[0].pos = _target;
 		
-		// proces sinitial joint
+		// process initial joint
 		joint_vec = norm3f(sub3f(target, _chain->nodes[1].pos));
-		target = sub3f(target, mul3f(joint_vec, _chain->nodes[0].length));
+		target = sub3f(target, mul3f(joint_vec, _chain->nodes[1].length));
 		_chain->nodes[1].pos = target;
 		_chain->nodes[1].rtn = joint_vec;
 		
@@ -124,13 +282,13 @@ int ik_chain_solve_fabrik(struct ik_chain* _chain, vec3f _target) {
 			joint_vec = norm3f(sub3f(target, _chain->nodes[k + 1].pos));
 			
 			// apply angle restrictions
-			joint_vec = __ik_clamp_vector_to_cone(
+			joint_vec = __ik_clamp_vector_to_limit(
 				_chain->nodes[k].rtn,
-				_chain->nodes[k].aperture,
+				&_chain->limits[k],
 				joint_vec
 			);
 			
-			target = sub3f(target, mul3f(joint_vec, _chain->nodes[k].length));
+			target = sub3f(target, mul3f(joint_vec, _chain->nodes[k + 1].length));
 			_chain->nodes[k + 1].pos = target;
 			_chain->nodes[k + 1].rtn = joint_vec;
 		}
@@ -142,7 +300,7 @@ int ik_chain_solve_fabrik(struct ik_chain* _chain, vec3f _target) {
 		
 		// process initial joint
 		joint_vec = norm3f(sub3f(_chain->nodes[_chain->num_nodes - 2].pos, target));
-		joint_vec = __ik_clamp_vector_to_cone(_chain->rtn, _chain->aperture, joint_vec);
+		joint_vec = __ik_clamp_vector_to_limit(_chain->rtn, &_chain->limit, joint_vec);
 		target = add3f(target, mul3f(joint_vec, _chain->nodes[_chain->num_nodes - 1].length));
 		_chain->nodes[_chain->num_nodes - 2].pos = target;
 		_chain->nodes[_chain->num_nodes - 1].rtn = joint_vec;
@@ -152,9 +310,9 @@ int ik_chain_solve_fabrik(struct ik_chain* _chain, vec3f _target) {
 			joint_vec = norm3f(sub3f(_chain->nodes[k - 1].pos, target));
 			
 			// apply angle restrictions
-			joint_vec = __ik_clamp_vector_to_cone(
+			joint_vec = __ik_clamp_vector_to_limit(
 				_chain->nodes[k + 1].rtn,
-				_chain->nodes[k + 1].aperture,
+				&_chain->limits[k + 1],
 				joint_vec
 			);
 			
@@ -165,23 +323,93 @@ int ik_chain_solve_fabrik(struct ik_chain* _chain, vec3f _target) {
 		
 		// set effector rotation
 		_chain->nodes[0].rtn = _chain->nodes[1].rtn;
+		
+		// stop early once an iteration no longer gets the effector closer
+		i++;
+		real last_error = error;
+		error = ik_chain_error(_chain, _target);
+		if (last_error - error < opts.min_improvement) break;
 	}
 	
+	if (_res) *_res = (struct ik_solve_result) {i, error};
 	return 0;
 }
 
-int ik_make_chain(struct ik_chain* _chain, short _num_nodes, double _length) {
+/* solves a chain that is solved again every frame with `ik_chain_solve`.
+ * when the target moved less than `skip_distance` since the last call the
+ * pose is kept as it is (`_res->iterations` is 0), otherwise the solve starts
+ * from the last pose, which is usually close, so it gets the smaller `warm`
+ * budget. `_opts` may be null to use `IK_WARM_DEFAULTS`, and `_res` may be
+ * null. */
+int ik_chain_solve_fabrik_warm(struct ik_chain* _chain, vec3f _target, struct ik_warm_opts* _opts, struct ik_solve_result* _res) {
+	struct ik_warm_opts opts = _opts ? *_opts : IK_WARM_DEFAULTS;
+	
+	if (_chain->warm && mag3f(sub3f(_target, _chain->last_target)) < opts.skip_distance) {
+		if (_res) *_res = (struct ik_solve_result) {0, ik_chain_error(_chain, _target)};
+		return 0;
+	}
+	
+	int ret = ik_chain_solve(_chain, _target, _chain->warm ? &opts.warm : &opts.cold, _res);
+	_chain->last_target = _target;
+	_chain->warm = 1;
+	return ret;
+}
+
+/* forgets the last solution of a chain, call after moving its nodes by hand
+ * so that the next `ik_chain_solve_fabrik_warm` does not skip the solve. */
+void ik_chain_invalidate(struct ik_chain* _chain) {
+	_chain->warm = 0;
+}
+
+/* internal function that caches the trigonometry of a joint limit */
+void __ik_update_limit(struct ik_limit* _limit, real _aperture) {
+#ifdef LINALG_DETERMINISTIC
+	// libm's sin and cos differ between implementations
+	real sin_ap_y, cos_ap_y;
+	SINCOS(_aperture, &_limit->sin_ap, &_limit->cos_ap);
+	SINCOS(_limit->aperture_y, &sin_ap_y, &cos_ap_y);
+	_limit->cot_ap = _limit->cos_ap / _limit->sin_ap;
+	_limit->cot_ap_y = cos_ap_y / sin_ap_y;
+#else
+	_limit->cos_ap = cos(_aperture);
+	_limit->sin_ap = sin(_aperture);
+	_limit->cot_ap = 1 / tan(_aperture);
+	_limit->cot_ap_y = 1 / tan(_limit->aperture_y);
+#endif
+}
+
+/* recomputes what the solvers cache about the joint limits of a chain, call
+ * after changing an `aperture`, or the `aperture_y` or `type` of a limit. */
+void ik_chain_update_limits(struct ik_chain* _chain) {
+	__ik_update_limit(&_chain->limit, _chain->aperture);
+	for (int i = 0; i < _chain->num_nodes; i++)
+		__ik_update_limit(&_chain->limits[i], _chain->nodes[i].aperture);
+}
+
+/* bytes of the block `ik_init_chain` lays out a chain of `_num_nodes` bones
+ * in (its nodes, then their limits, then the CCD scratch) */
+#define IK_CHAIN_SIZE(_num_nodes) (((_num_nodes) + 1) * (sizeof(struct ik_node) + sizeof(struct ik_limit) + sizeof(qtrn)))
+
+/* sets up a straight chain of `_num_nodes` bones of length `_length` along
+ * the x axis in `_block` (`IK_CHAIN_SIZE(_num_nodes)` bytes, aligned for a
+ * `real`), the nodes start at the beginning of it. */
+void ik_init_chain(struct ik_chain* _chain, void* _block, short _num_nodes, real _length) {
+	_chain->nodes = _block;
+	_chain->limits = (struct ik_limit*) (_chain->nodes + _num_nodes + 1);
+	_chain->pending = (qtrn*) (_chain->limits + _num_nodes + 1);
 	_chain->num_nodes = _num_nodes + 1;
 	_chain->aperture = PI/2;
 	_chain->rtn = (vec3f) {1, 0, 0};
+	_chain->warm = 0;
 	
-	_chain->nodes = malloc(_chain->num_nodes * sizeof(struct ik_node));
-	if (!_chain->nodes) XERR("failed to allocate memory!", ERROR_FAILED_ALLOCATE);
+	// root of the chain sits at the origin
+	_chain->nodes[_num_nodes].pos = (vec3f) {0, 0, 0};
 	
 	for (int i = _num_nodes; i > 0; i--) {
 		_chain->nodes[i].length = _length;
 		_chain->nodes[i].aperture = PI/6;
 		_chain->nodes[i].rtn = (vec3f) {1, 0, 0};
+		if (i == _num_nodes) continue;
 		_chain->nodes[i].pos.x = _chain->nodes[i + 1].pos.x + _chain->nodes[i + 1].length;
 		_chain->nodes[i].pos.y = _chain->nodes[i].pos.z = 0;
 	}
@@ -192,6 +420,35 @@ int ik_make_chain(struct ik_chain* _chain, short _num_nodes, double _length) {
 	_chain->nodes[0].pos.x = _chain->nodes[1].pos.x + _chain->nodes[1].length;
 	_chain->nodes[0].pos.y = _chain->nodes[0].pos.z = 0;
 	
+	// every joint starts out with a circular limit, which stays circular if
+	// its type is changed to IK_LIMIT_ELLIPSE
+	_chain->limit = (struct ik_limit) {.type = IK_LIMIT_CONE, .aperture_y = _chain->aperture, .up = {0, 0, 1}};
+	for (int i = 0; i <= _num_nodes; i++)
+		_chain->limits[i] = (struct ik_limit) {.type = IK_LIMIT_CONE, .aperture_y = _chain->nodes[i].aperture, .up = {0, 0, 1}};
+	ik_chain_update_limits(_chain);
+}
+
+/* same as `ik_init_chain` but allocates the chain's block, free it with
+ * `free(_chain->nodes)`. (returns -1 on error) */
+int ik_make_chain(struct ik_chain* _chain, short _num_nodes, real _length) {
+	void* block = malloc(IK_CHAIN_SIZE(_num_nodes));
+	if (!block) return -1;
+	
+	ik_init_chain(_chain, block, _num_nodes, _length);
+	return 0;
+}
+
+/* arena bytes that `ik_make_chain_arena` takes for `_num_nodes` bones */
+#define IK_CHAIN_ARENA_SIZE(_num_nodes) (IK_CHAIN_SIZE(_num_nodes) + ARENA_ALIGN)
+
+/* same as `ik_init_chain` but takes the chain's block from `_arena`, so that
+ * the chains of a scene share one block and are all released by resetting
+ * it. (returns -1 if the arena is full) */
+int ik_make_chain_arena(struct ik_chain* _chain, struct arena* _arena, short _num_nodes, real _length) {
+	void* block = arena_alloc(_arena, IK_CHAIN_SIZE(_num_nodes));
+	if (!block) return -1;
+	
+	ik_init_chain(_chain, block, _num_nodes, _length);
 	return 0;
 }
 
@@ -199,8 +456,8 @@ int ik_reset_chain(struct ik_chain* _chain) {
 	_chain->nodes[_chain->num_nodes - 1].rtn = (vec3f) {1, 0, 0};
 	_chain->nodes[_chain->num_nodes - 1].pos = (vec3f) {0, 0, 0};
 	
-	for (int i = _chain->num_nodes - 1; i > 0; i--) {
-		_chain->nodes[i].rtn = _chain->nodes[i].rtn = (vec3f) {1, 0, 0};
+	for (int i = _chain->num_nodes - 2; i > 0; i--) {
+		_chain->nodes[i].rtn = (vec3f) {1, 0, 0};
 		_chain->nodes[i].pos.x = _chain->nodes[i + 1].pos.x + _chain->nodes[i + 1].length;
 		_chain->nodes[i].pos.y = _chain->nodes[i].pos.z = 0;
 	}
@@ -209,9 +466,23 @@ int ik_reset_chain(struct ik_chain* _chain) {
 	_chain->nodes[0].pos.x = _chain->nodes[1].pos.x + _chain->nodes[1].length;
 	_chain->nodes[0].pos.y = _chain->nodes[0].pos.z = 0;
 	
+	ik_chain_invalidate(_chain);
 	return 0;
 }
 
+// solvers built on top of the single chain solvers above
+#include "inc/ik_simd.h"
+#include "inc/ik_batch.h"
+#include "inc/ik_soa.h"
+#include "inc/ik_analytic.h"
+#include "inc/ik_jacobian.h"
+#include "inc/ik_tree.h"
+#include "inc/ik_fixed.h"
+#include "inc/ik_replay.h"
+#include "inc/ik_trajectory.h"
+#include "inc/ik_pose.h"
+#include "inc/ik_shm.h"
+
 int ik_draw_chain(struct ik_chain* _chain, int _x_off, int _y_off) {
 	for (int i = 1; i < _chain->num_nodes; i++) {
 		// draw bone
@@ -254,13 +525,28 @@ int ik_draw_chain(struct ik_chain* _chain, int _x_off, int _y_off) {
 	return 0;
 }
 
+/* draws a frame of the demo scene: `_chain` and its target `_target` */
+void ik_draw_demo(struct ik_chain* _chain, vec3f _target) {
+	ik_draw_chain(_chain, 200, 200);
+	fb_draw_centroid((rgbx32) {255, 255, 0, 255}, _target.x + 200, _target.y + 200);
+}
+
+// ik_server.c and ik_client.c bring their own main
+#ifndef IK_NO_MAIN
 int main(void) {
 	fb_init("/dev/fb0");
 	mouse_init("/dev/input/mice");
 	
+	// draw the next frame while the last one is put on the screen
+	if (fb_async_start() == -1) XERR("failed to start the present thread!", ERROR_FAILED_ALLOCATE);
+	
+	// every chain of the scene lives in this arena
+	struct arena scene;
+	if (arena_init(&scene, 1 << 16) == -1) XERR("failed to allocate memory!", ERROR_FAILED_ALLOCATE);
+	
 	struct ik_chain n1;
 	vec3f t = {-100.0, 100.0, 0.0};
-	ik_make_chain(&n1, 100, 5);
+	if (ik_make_chain_arena(&n1, &scene, 100, 5) == -1) XERR("scene arena is full!", ERROR_FAILED_ALLOCATE);
 	
 	mouse_event ev;
 	
@@ -270,15 +556,15 @@ int main(void) {
 		if (ev.lbtn) t.z += 10.0;
 		if (ev.rbtn) t.z -= 10.0;
 		
-		t.x += (double) ev.rel_x;
-		t.y -= (double) ev.rel_y;
-		
+		t.x += (real) ev.rel_x;
+		t.y -= (real) ev.rel_y;
+
 //		ik_reset_chain(&n1);
-		ik_chain_solve_fabrik(&n1, t);
-		ik_draw_chain(&n1, 200, 200);
-		fb_draw_centroid((rgbx32) {255, 255, 0, 255}, t.x + 200, t.y + 200);
+		ik_chain_solve_fabrik_warm(&n1, t, 0, 0);
+		ik_draw_demo(&n1, t);
 		fb_swap();
 	}
 }
+#endif
 
 #endif
\ No newline at end of file
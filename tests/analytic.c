@@ -0,0 +1,127 @@
+/* tests of the closed form solvers of inc/ik_analytic.h. with limits wide
+ * enough for any bend, two and three bone chains have to land exactly on
+ * reachable targets with their bone lengths kept. with the default limits
+ * `ik_chain_solve` has to solve targets close to full reach in closed form,
+ * within the limits, and leave the rest to FABRIK exactly as
+ * `ik_chain_solve_fabrik` would. returns non-zero if a check fails.
+ *
+ *     make test_analytic */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define ANALYTIC_TARGETS 1000
+#define ANALYTIC_BOUND 1e-9 // for positions and bone lengths, in units
+
+static int __test_failed = 0;
+static unsigned __test_seed = 1;
+
+static real __test_rand(void) {
+	__test_seed = __test_seed * 1103515245 + 12345;
+	return (real) ((__test_seed >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+/* a random target between `_min` and `_max` units from the origin */
+static vec3f __test_target(real _min, real _max) {
+	vec3f dir = {__test_rand() - 0.5, __test_rand() - 0.5, __test_rand() - 0.5};
+	return mul3f(norm3f(dir), _min + (_max - _min) * __test_rand());
+}
+
+/* largest difference between a bone's length and its nodes' distance */
+static real __test_length_error(struct ik_chain* _chain) {
+	real worst = 0;
+	for (int k = _chain->num_nodes - 1; k > 0; k--) {
+		real d = fabs(mag3f(sub3f(_chain->nodes[k - 1].pos, _chain->nodes[k].pos)) - _chain->nodes[k].length);
+		if (d > worst) worst = d;
+	}
+	
+	return worst;
+}
+
+static void __test_report(const char* _name, int _ok, const char* _fmt, double _value) {
+	printf("%s %s: ", _ok ? "ok  " : "FAIL", _name);
+	printf(_fmt, _value);
+	printf("\n");
+	if (!_ok) __test_failed = 1;
+}
+
+/* closed form solves of `_bones` bones with limits that allow any bend */
+static void __test_exact(int _bones) {
+	struct ik_chain chain;
+	real error = 0, length = 0;
+	if (ik_make_chain(&chain, _bones, 100) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+	
+	chain.aperture = PI;
+	for (int k = 0; k < chain.num_nodes; k++) chain.nodes[k].aperture = PI;
+	ik_chain_update_limits(&chain);
+	
+	for (int i = 0; i < ANALYTIC_TARGETS; i++) {
+		struct ik_solve_result res;
+		vec3f target = __test_target(_bones == 2 ? 1 : 10, 100 * _bones - 1);
+		
+		if (ik_chain_solve(&chain, target, 0, &res) == -1 || res.iterations != 1) {
+			printf("FAIL %d bones: target %d was not solved in closed form\n", _bones, i);
+			__test_failed = 1;
+			break;
+		}
+		
+		if (res.error > error) error = res.error;
+		if (__test_length_error(&chain) > length) length = __test_length_error(&chain);
+	}
+	
+	char name[64];
+	snprintf(name, sizeof(name), "%d bones, any bend, error", _bones);
+	__test_report(name, error <= ANALYTIC_BOUND, "%g", error);
+	snprintf(name, sizeof(name), "%d bones, any bend, bone lengths", _bones);
+	__test_report(name, length <= ANALYTIC_BOUND, "%g", length);
+	free(chain.nodes);
+}
+
+/* `ik_chain_solve` with the default limits against FABRIK from the same
+ * pose: a pose that is not FABRIK's has to be a closed form solve whose
+ * bends fit */
+static void __test_limits(int _bones) {
+	struct ik_chain chain, fabrik;
+	int closed = 0, unfit = 0, broken = 0;
+	real error = 0;
+	
+	if (ik_make_chain(&chain, _bones, 100) == -1 || ik_make_chain(&fabrik, _bones, 100) == -1)
+		XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+	
+	for (int i = 0; i < ANALYTIC_TARGETS; i++) {
+		struct ik_solve_result res;
+		vec3f target = __test_target(100 * _bones * (i & 1 ? 0.95 : 0.3), 100 * _bones);
+		
+		ik_reset_chain(&chain);
+		ik_reset_chain(&fabrik);
+		int fits = __ik_analytic_fits(&chain, target);
+		ik_chain_solve(&chain, target, 0, &res);
+		ik_chain_solve_fabrik(&fabrik, target, 0, 0);
+		
+		if (!memcmp(chain.nodes, fabrik.nodes, chain.num_nodes * sizeof(struct ik_node))) continue;
+		
+		closed++;
+		if (!fits) unfit++;
+		if (!__ik_chain_within_limits(&chain)) broken++;
+		if (res.error > error) error = res.error;
+	}
+	
+	char name[64];
+	snprintf(name, sizeof(name), "%d bones, default limits, closed form solves", _bones);
+	__test_report(name, closed > 0 && unfit == 0, "%g", closed);
+	snprintf(name, sizeof(name), "%d bones, default limits, closed form error", _bones);
+	__test_report(name, error <= ANALYTIC_BOUND, "%g", error);
+	snprintf(name, sizeof(name), "%d bones, default limits, broken limits", _bones);
+	__test_report(name, broken == 0, "%g", broken);
+	
+	free(chain.nodes);
+	free(fabrik.nodes);
+}
+
+int main(void) {
+	__test_exact(2);
+	__test_exact(3);
+	__test_limits(2);
+	__test_limits(3);
+	return __test_failed;
+}
@@ -0,0 +1,103 @@
+/* tests of the batch solvers of inc/ik_batch.h against solving every chain
+ * on its own. the batch holds runs of equally long chains (so the lockstep
+ * solver fills its packs) and a few with an elliptical limit (which it has
+ * to leave to the scalar solver), and solves several frames of moving
+ * targets. the scalar and threaded solvers have to give the poses and
+ * results of the per-chain solves bit for bit, the lockstep one within
+ * BATCH_BOUND. returns non-zero if a check fails.
+ *
+ *     make test_batch */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define BATCH_CHAINS 60
+#define BATCH_FRAMES 10
+#define BATCH_BOUND 1e-9 // the packs mirror the scalar math bit for bit
+
+enum {BATCH_FABRIK, BATCH_CCD, BATCH_SIMD, BATCH_FABRIK_MT, BATCH_CCD_MT};
+static const char* __test_solvers[] = {"fabrik", "ccd", "simd", "fabrik mt", "ccd mt"};
+
+static int __test_failed = 0;
+static struct tp_pool __test_pool;
+
+/* chain `_i` of the batch: runs of 4, 8 and 16 bones, every seventh with an
+ * elliptical limit */
+static void __test_chain(struct ik_chain* _chain, int _i) {
+	int bones = 4 << (_i / 20);
+	if (ik_make_chain(_chain, bones, 40.0 / bones) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+	
+	if (_i % 7 == 3) {
+		_chain->limits[2].type = IK_LIMIT_ELLIPSE;
+		_chain->limits[2].aperture_y = PI/12;
+		ik_chain_update_limits(_chain);
+	}
+}
+
+static vec3f __test_target(int _i, int _frame) {
+	real t = _i * 0.9 + _frame * 0.2;
+	return (vec3f) {25 + 10 * cos(t), 15 * sin(1.3 * t), 5 * sin(0.7 * t)};
+}
+
+static void __test_solver(int _solver) {
+	struct ik_chain single[BATCH_CHAINS];
+	struct ik_batch batch;
+	vec3f targets[BATCH_CHAINS];
+	real worst = 0;
+	int mismatched = 0;
+	
+	if (ik_batch_init(&batch, BATCH_CHAINS, BATCH_CHAINS * 17) == -1) XERR("failed to allocate the batch!", ERROR_FAILED_ALLOCATE);
+	
+	for (int i = 0; i < BATCH_CHAINS; i++) {
+		__test_chain(&single[i], i);
+		if (ik_batch_add_chain(&batch, &single[i]) == -1) XERR("failed to fill the batch!", ERROR_FAILED_ALLOCATE);
+	}
+	
+	for (int f = 0; f < BATCH_FRAMES; f++) {
+		for (int i = 0; i < BATCH_CHAINS; i++) targets[i] = __test_target(i, f);
+		
+		switch (_solver) {
+			case BATCH_FABRIK: ik_batch_solve_fabrik(&batch, targets, 0); break;
+			case BATCH_CCD: ik_batch_solve_ccd(&batch, targets, 1, 0); break;
+			case BATCH_SIMD: ik_batch_solve_fabrik_simd(&batch, targets, 0); break;
+			case BATCH_FABRIK_MT: ik_batch_solve_fabrik_mt(&batch, targets, 0, &__test_pool); break;
+			case BATCH_CCD_MT: ik_batch_solve_ccd_mt(&batch, targets, 1, 0, &__test_pool); break;
+		}
+		
+		for (int i = 0; i < BATCH_CHAINS; i++) {
+			struct ik_solve_result res;
+			int ccd = _solver == BATCH_CCD || _solver == BATCH_CCD_MT;
+			
+			if (ccd) ik_chain_solve_ccd(&single[i], targets[i], 1, 0, &res);
+			else ik_chain_solve_fabrik(&single[i], targets[i], 0, &res);
+			
+			if (res.iterations != batch.results[i].iterations || fabs(res.error - batch.results[i].error) > BATCH_BOUND) mismatched++;
+			
+			for (int k = 0; k < single[i].num_nodes; k++) {
+				real d = mag3f(sub3f(single[i].nodes[k].pos, batch.chains[i].nodes[k].pos));
+				real r = mag3f(sub3f(single[i].nodes[k].rtn, batch.chains[i].nodes[k].rtn));
+				if (d > worst) worst = d;
+				if (r > worst) worst = r;
+			}
+		}
+	}
+	
+	int ok = mismatched == 0 && (_solver == BATCH_SIMD ? worst <= BATCH_BOUND : worst == 0);
+	printf(
+		"%s %s: %d of %d results differ, poses off by %g\n",
+		ok ? "ok  " : "FAIL", __test_solvers[_solver], mismatched, BATCH_CHAINS * BATCH_FRAMES, (double) worst
+	);
+	if (!ok) __test_failed = 1;
+	
+	for (int i = 0; i < BATCH_CHAINS; i++) free(single[i].nodes);
+	ik_batch_free(&batch);
+}
+
+int main(void) {
+	if (tp_init(&__test_pool, 4, IK_BATCH_MAX_JOBS) == -1) XERR("failed to start the thread pool!", ERROR_FAILED_ALLOCATE);
+	
+	for (int s = BATCH_FABRIK; s <= BATCH_CCD_MT; s++) __test_solver(s);
+	
+	tp_destroy(&__test_pool);
+	return __test_failed;
+}
@@ -0,0 +1,144 @@
+/* benchmark of the screen writes of inc/linuxfb.h: memcpy and memset
+ * against the SSE2 and AVX streaming stores of `fb_blit_row`. whole 1080p
+ * and 4K frames are written row by row, and the tiles a frame of the demo
+ * damages are written as spans of one tile row (32 rows of `span` bytes,
+ * scattered over a 1080p frame, so still in the cache from the last frame
+ * like a swap finds them). the destination is plain memory, a write
+ * combined framebuffer mapping favours streaming stores more. the smallest
+ * span where streaming wins is what `FB_STREAM_MIN` is set from.
+ *
+ *     make bench_blit */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define BLIT_RUNS 20 // the best of these is reported
+#define BLIT_TILES 64 // damaged tiles per frame
+
+enum {BLIT_MEM, BLIT_SSE2, BLIT_AVX};
+static const char* __blit_names[] = {"memcpy/memset", "sse2", "avx"};
+
+static char* __blit_src;
+static char* __blit_dst;
+
+/* internal function that writes `_n` bytes at `_dst` the way `_how` says */
+static void __blit_row(int _how, char* _dst, char* _src, size_t _n) {
+	switch (_how) {
+		#ifdef FB_X86
+			case BLIT_SSE2: __fb_stream_sse2(_dst, _src, _n); return;
+			case BLIT_AVX: __fb_stream_avx(_dst, _src, _n); return;
+		#endif
+	}
+	
+	if (_src) memcpy(_dst, _src, _n);
+	else memset(_dst, 0, _n);
+}
+
+/* microseconds to copy (or with `_clear`, clear) the rows of a `_xres` x
+ * `_yres` frame */
+static double __blit_frame(int _how, int _clear, int _xres, int _yres) {
+	size_t row = _xres * 4;
+	double best = 1e30;
+	
+	for (int run = 0; run < BLIT_RUNS; run++) {
+		uint64_t start = __tp_now_ns();
+		
+		for (int y = 0; y < _yres; y++)
+			__blit_row(_how, __blit_dst + y * row, _clear ? 0 : __blit_src + y * row, row);
+		
+		#ifdef FB_X86
+			if (_how != BLIT_MEM) _mm_sfence();
+		#endif
+		
+		double us = (__tp_now_ns() - start) / 1000.0;
+		if (us < best) best = us;
+	}
+	
+	return best;
+}
+
+/* microseconds to copy (or clear) `BLIT_TILES` spans of `_span` bytes and
+ * `FB_TILE` rows each, scattered over a 1080p frame */
+static double __blit_tiles(int _how, int _clear, size_t _span) {
+	size_t row = 1920 * 4;
+	double best = 1e30;
+	
+	for (int run = 0; run < BLIT_RUNS; run++) {
+		uint64_t start = __tp_now_ns();
+		
+		for (int t = 0; t < BLIT_TILES; t++) {
+			// tile rows 7 apart, 3 tiles further right each time
+			size_t x = (t * 3 * FB_TILE * 4) % (row - _span + 1) & ~(size_t) 127;
+			size_t y0 = (t * 7 % (1080 / FB_TILE)) * FB_TILE;
+			
+			for (size_t y = y0; y < y0 + FB_TILE; y++)
+				__blit_row(_how, __blit_dst + y * row + x, _clear ? 0 : __blit_src + y * row + x, _span);
+		}
+		
+		#ifdef FB_X86
+			if (_how != BLIT_MEM) _mm_sfence();
+		#endif
+		
+		double us = (__tp_now_ns() - start) / 1000.0;
+		if (us < best) best = us;
+	}
+	
+	return best;
+}
+
+int main(void) {
+	static const int res[2][2] = {{1920, 1080}, {3840, 2160}};
+	static const size_t spans[] = {128, 256, 512, 1024, 2048, 4096, 7680};
+	int hows = 1;
+	
+	#ifdef FB_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("sse2")) hows = 2;
+		if (__builtin_cpu_supports("avx")) hows = 3;
+	#endif
+	
+	size_t size = 3840 * 2160 * 4;
+	__blit_src = (char*) mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	__blit_dst = (char*) mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (__blit_src == (char*) -1 || __blit_dst == (char*) -1) XERR("failed to map the buffers!", ERROR_FAILED_ALLOCATE);
+	
+	// touch every page before timing
+	for (size_t i = 0; i < size; i += 4096) __blit_src[i] = (char) i, __blit_dst[i] = 0;
+	
+	for (int clear = 0; clear < 2; clear++) {
+		size_t wins = 0; // smallest span from which the best streaming path wins
+		
+		printf("%s (us)         ", clear ? "clear" : "copy ");
+		for (int h = 0; h < hows; h++) printf("%-15s", __blit_names[h]);
+		printf("\n");
+		
+		for (int r = 0; r < 2; r++) {
+			printf("%4d x %-4d frame    ", res[r][0], res[r][1]);
+			for (int h = 0; h < hows; h++) printf("%-15.1f", __blit_frame(h, clear, res[r][0], res[r][1]));
+			printf("\n");
+		}
+		
+		for (int s = 0; s < (int) (sizeof(spans) / sizeof(spans[0])); s++) {
+			double plain = 0, stream = 1e30;
+			
+			printf("%2d tiles of %-4zu B  ", BLIT_TILES, spans[s]);
+			for (int h = 0; h < hows; h++) {
+				double us = __blit_tiles(h, clear, spans[s]);
+				printf("%-15.1f", us);
+				
+				if (h == BLIT_MEM) plain = us;
+				else if (us < stream) stream = us;
+			}
+			printf("\n");
+			
+			if (stream < plain && !wins) wins = spans[s];
+			if (stream >= plain) wins = 0;
+		}
+		
+		if (hows > 1 && wins) printf("streaming wins from %zu byte spans\n\n", wins);
+		else if (hows > 1) printf("streaming does not win\n\n");
+		else printf("\n");
+	}
+	
+	return 0;
+}
@@ -0,0 +1,143 @@
+/* tests of `ik_chain_solve_ccd`. from the straight chain, CCD has to bring
+ * the effector within CCD_TOLERANCE of targets well inside its reach, far
+ * closer than the turns it skipped as too small used to allow (0.003 units
+ * on 75 unit bones). its poses, built through `struct ik_fk`, also have to
+ * match those of rewriting every node below a joint right after turning it,
+ * and chains set up in a caller's block have to come with their scratch.
+ * built in the exact math tier, where the two only differ by rounding (the
+ * fast `RSQRT` normalises at different points in the two and they drift
+ * apart by 1e-4 of the reach). returns non-zero if a check fails.
+ *
+ *     make test_ccd */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define CCD_TARGETS 200
+#define CCD_REACH 300 // length of every chain, split into equal bones
+#define CCD_TOLERANCE 0.00001
+#define CCD_ITERATIONS 20 // of the comparison with the direct rewrite
+#define CCD_BOUND 0.000000001 // of the comparison, relative to the reach
+
+static int __test_failed = 0;
+static unsigned __test_seed = 1;
+
+static real __test_rand(void) {
+	__test_seed = __test_seed * 1103515245 + 12345;
+	return (real) ((__test_seed >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+static void __test_report(const char* _name, int _ok, const char* _fmt, double _value) {
+	printf("%s %s: ", _ok ? "ok  " : "FAIL", _name);
+	printf(_fmt, _value);
+	printf("\n");
+	if (!_ok) __test_failed = 1;
+}
+
+/* a random target between `_min` and `_max` units from the origin */
+static vec3f __test_target(real _min, real _max) {
+	vec3f dir = {__test_rand() - 0.5, __test_rand() - 0.5, __test_rand() - 0.5};
+	return mul3f(norm3f(dir), _min + (_max - _min) * __test_rand());
+}
+
+/* cold solves of targets up to 70% of the reach of the chain */
+static void __test_converges(int _bones) {
+	struct ik_chain chain;
+	struct ik_solve_opts opts = {1000, CCD_TOLERANCE, 0};
+	int converged = 0;
+	
+	if (ik_make_chain(&chain, _bones, (real) CCD_REACH / _bones) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+	
+	for (int i = 0; i < CCD_TARGETS; i++) {
+		struct ik_solve_result res;
+		ik_reset_chain(&chain);
+		ik_chain_solve_ccd(&chain, __test_target(0.1 * CCD_REACH, 0.7 * CCD_REACH), 1, &opts, &res);
+		if (res.error <= CCD_TOLERANCE) converged++;
+	}
+	
+	char name[64];
+	snprintf(name, sizeof(name), "%d bones, converged", _bones);
+	__test_report(name, converged == CCD_TARGETS, "%g targets", converged);
+	free(chain.nodes);
+}
+
+/* CCD rotating every joint right away, rewriting the directions and
+ * positions of all the nodes below it (O(n^2) an iteration) */
+static void __test_ccd_direct(struct ik_chain* _chain, vec3f _target, int _iterations) {
+	for (int i = 0; i < _iterations; i++) {
+		for (short k = 1; k < _chain->num_nodes; k++) {
+			vec3f effector_vec = sub3f(_chain->nodes[0].pos, _chain->nodes[k].pos);
+			vec3f target_vec = sub3f(_target, _chain->nodes[k].pos);
+			real denom = mag3f(effector_vec) * mag3f(target_vec);
+			real cos_phi = dot3f(effector_vec, target_vec) / denom;
+			vec3f normal = cross3f(effector_vec, target_vec);
+			real phi;
+			
+			if (cos_phi > 0.999999999) phi = mag3f(normal) / denom;
+			else if (cos_phi < -0.999999999) phi = PI;
+			else phi = ACOS(cos_phi);
+			if (phi == 0) continue;
+			
+			qtrn rot = make_qrot(norm3f(normal), phi);
+			_chain->nodes[k].rtn = norm3f(qrot(rot, _chain->nodes[k].rtn));
+			for (int n = k - 1; n >= 0; n--) {
+				_chain->nodes[n].rtn = norm3f(qrot(rot, _chain->nodes[n].rtn));
+				_chain->nodes[n].pos = add3f(_chain->nodes[n + 1].pos, mul3f(_chain->nodes[n + 1].rtn, _chain->nodes[n + 1].length));
+			}
+		}
+	}
+}
+
+/* fixed iteration counts of both, from the same straight chain */
+static void __test_matches_direct(int _bones) {
+	struct ik_chain chain, direct;
+	struct ik_solve_opts opts = {CCD_ITERATIONS, 0, -INFINITY}; // never stop early
+	real worst = 0;
+	
+	if (ik_make_chain(&chain, _bones, (real) CCD_REACH / _bones) == -1 ||
+		ik_make_chain(&direct, _bones, (real) CCD_REACH / _bones) == -1) XERR("failed to allocate the chains!", ERROR_FAILED_ALLOCATE);
+	
+	for (int i = 0; i < CCD_TARGETS; i++) {
+		vec3f target = __test_target(0.1 * CCD_REACH, 0.9 * CCD_REACH);
+		ik_reset_chain(&chain);
+		ik_reset_chain(&direct);
+		ik_chain_solve_ccd(&chain, target, 1, &opts, 0);
+		__test_ccd_direct(&direct, target, CCD_ITERATIONS);
+		
+		for (int k = 0; k < chain.num_nodes; k++) {
+			real d = mag3f(sub3f(chain.nodes[k].pos, direct.nodes[k].pos)) / CCD_REACH;
+			if (!(d <= worst)) worst = isnan(d) ? INFINITY : d;
+		}
+	}
+	
+	char name[64];
+	snprintf(name, sizeof(name), "%d bones, matches the direct rewrite", _bones);
+	__test_report(name, worst <= CCD_BOUND, "%g", worst);
+	free(chain.nodes);
+	free(direct.nodes);
+}
+
+/* a chain set up in a block of the caller's (on the stack here) */
+static void __test_block(void) {
+	char block[IK_CHAIN_SIZE(8)] __attribute__((aligned(16)));
+	struct ik_chain chain;
+	struct ik_solve_result res;
+	struct ik_solve_opts opts = {1000, CCD_TOLERANCE, 0};
+	
+	ik_init_chain(&chain, block, 8, (real) CCD_REACH / 8);
+	int ret = ik_chain_solve_ccd(&chain, (vec3f) {100, 50, -20}, 1, &opts, &res);
+	
+	__test_report("chains set up in a block have scratch", chain.pending && (char*) chain.pending + 9 * sizeof(qtrn) <= block + sizeof(block), "%g", !!chain.pending);
+	__test_report("chains set up in a block solve", ret == 0 && res.error <= CCD_TOLERANCE, "%g", res.error);
+}
+
+int main() {
+	__test_converges(4);
+	__test_converges(16);
+	__test_matches_direct(4);
+	__test_matches_direct(16);
+	__test_matches_direct(64);
+	__test_block();
+	
+	return __test_failed;
+}
@@ -0,0 +1,85 @@
+/* benchmark of `ik_chain_solve` against calling `ik_chain_solve_fabrik`
+ * directly on two and three bone chains, with the default limits (30 degree
+ * joints, so only targets close to full reach fit the closed form) and with
+ * limits that allow any bend. targets are scattered between 30% and full
+ * reach and solved from the straight chain.
+ *
+ *     make bench_dispatch */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define BENCH_TARGETS 20000
+#define BENCH_RUNS 5 // the best of these is reported
+
+static unsigned __bench_seed = 1;
+
+static real __bench_rand(void) {
+	__bench_seed = __bench_seed * 1103515245 + 12345;
+	return (real) ((__bench_seed >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+/* nanoseconds per solve of `_chain` towards every target, and with `_closed`
+ * the share of solves that took one iteration */
+static double __bench_run(struct ik_chain* _chain, vec3f* _targets, int _dispatch, double* _closed) {
+	double best = 1e30;
+	
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		struct ik_solve_result res;
+		uint64_t ns = 0;
+		int closed = 0;
+		
+		// resetting is not part of the cost
+		for (int i = 0; i < BENCH_TARGETS; i++) {
+			ik_reset_chain(_chain);
+			
+			uint64_t start = __tp_now_ns();
+			if (_dispatch) ik_chain_solve(_chain, _targets[i], 0, &res);
+			else ik_chain_solve_fabrik(_chain, _targets[i], 0, &res);
+			ns += __tp_now_ns() - start;
+			
+			closed += res.iterations == 1;
+		}
+		
+		if (ns < best) best = ns;
+		*_closed = (double) closed / BENCH_TARGETS;
+	}
+	
+	return best / BENCH_TARGETS;
+}
+
+int main(void) {
+	static vec3f targets[BENCH_TARGETS];
+	
+	printf("bones  limits   fabrik ns  ik_chain_solve ns  closed form\n");
+	
+	for (int bones = 2; bones <= 3; bones++) {
+		for (int any = 0; any < 2; any++) {
+			struct ik_chain chain;
+			double closed, fabrik_ns, solve_ns;
+			if (ik_make_chain(&chain, bones, 100) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+			
+			if (any) {
+				chain.aperture = PI;
+				for (int k = 0; k < chain.num_nodes; k++) chain.nodes[k].aperture = PI;
+				ik_chain_update_limits(&chain);
+			}
+			
+			for (int i = 0; i < BENCH_TARGETS; i++) {
+				vec3f dir = norm3f((vec3f) {__bench_rand() - 0.5, __bench_rand() - 0.5, __bench_rand() - 0.5});
+				targets[i] = mul3f(dir, 100 * bones * (0.3 + 0.7 * __bench_rand()));
+			}
+			
+			fabrik_ns = __bench_run(&chain, targets, 0, &closed);
+			solve_ns = __bench_run(&chain, targets, 1, &closed);
+			printf(
+				"%-6d %-8s %-10.0f %-18.0f %.0f%%\n",
+				bones, any ? "any" : "default", fabrik_ns, solve_ns, 100 * closed
+			);
+			
+			free(chain.nodes);
+		}
+	}
+	
+	return 0;
+}
@@ -0,0 +1,104 @@
+/* tests of the Q16.16 fixed point math and FABRIK (see inc/fixed.h and
+ * inc/ik_fixed.h) against libm and the floating point solver. returns
+ * non-zero if an error goes past its bound.
+ *
+ *     make test_fixed */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define FX_RSQRT_BOUND 0.000017 // relative, absolute for results below 1
+#define FX_ACOS_BOUND 0.000049 // radians
+#define FX_NORM_BOUND 0.000029 // per component of a unit vector
+#define FX_POS_BOUND 0.006 // units, node positions after a solve
+#define FX_LENGTH_BOUND 0.0002 // units, bone lengths after a solve
+
+static int __test_failed = 0;
+
+static void __test_check(const char* _name, double _error, double _bound) {
+	printf("%s %s: max error %g (bound %g)\n", _error > _bound ? "FAIL" : "ok  ", _name, _error, _bound);
+	if (_error > _bound) __test_failed = 1;
+}
+
+/* small deterministic generator so runs are comparable */
+static uint32_t __test_seed = 12345;
+static double __test_rand(void) {
+	__test_seed = __test_seed * 1664525 + 1013904223;
+	return (double) (__test_seed >> 8) / (1 << 24);
+}
+
+int main(void) {
+	double err;
+	fx_init();
+	
+	// reciprocal square root over the whole positive range (results below 1
+	// cannot be better than their last place)
+	err = 0;
+	for (int64_t x = 1; x < INT32_MAX; x += x / 4096 + 1) {
+		double want = 1 / sqrt((double) x / FX_ONE);
+		double e = fabs(fx_to_real(fx_rsqrt((fix16) x)) - want) / fmax(want, 1);
+		if (e > err) err = e;
+	}
+	__test_check("fx_rsqrt", err, FX_RSQRT_BOUND);
+	
+	// arc cosine at every representable input
+	err = 0;
+	for (fix16 x = -FX_ONE; x <= FX_ONE; x++) {
+		double e = fabs(fx_to_real(fx_acos(x)) - acos((double) x / FX_ONE));
+		if (e > err) err = e;
+	}
+	__test_check("fx_acos", err, FX_ACOS_BOUND);
+	
+	// normalising vectors from 1 to 10000 units long (shorter ones are not
+	// represented well enough in Q16.16 to have a precise direction)
+	err = 0;
+	for (int i = 0; i < 100000; i++) {
+		double s = pow(10, 4 * __test_rand());
+		vec3f v = {s * (2 * __test_rand() - 1), s * (2 * __test_rand() - 1), s * (2 * __test_rand() - 1)};
+		if (mag3f(v) < 1) continue;
+		
+		vec3f want = norm3f(v), got = vec3x_to_real(norm3x(vec3x_from_real(v)));
+		double e = fmax(fabs(got.x - want.x), fmax(fabs(got.y - want.y), fabs(got.z - want.z)));
+		if (e > err) err = e;
+	}
+	__test_check("norm3x", err, FX_NORM_BOUND);
+	
+	// the 100 node demo chain, solved by both solvers for the same number of
+	// iterations towards targets along a path
+	struct ik_chain chain;
+	struct ik_chain_fx fx;
+	if (ik_make_chain(&chain, 100, 5) == -1 || ik_chain_to_fx(&fx, &chain) == -1)
+		XERR("failed to allocate the chains!", ERROR_FAILED_ALLOCATE);
+	
+	struct ik_solve_opts opts = {10, 0, -1};
+	struct ik_solve_opts_fx opts_fx = {10, 0, INT32_MIN};
+	double pos_err = 0, length_err = 0;
+	
+	for (int f = 0; f < 200; f++) {
+		vec3f target = {-100 + 150 * cos(f * 0.05), 100 + 150 * sin(f * 0.05), 40 * sin(f * 0.02)};
+		
+		// both start from the same pose, so errors do not carry over frames
+		for (int k = 0; k < chain.num_nodes; k++)
+			fx.nodes[k].pos = vec3x_from_real(chain.nodes[k].pos),
+			fx.nodes[k].rtn = vec3x_from_real(chain.nodes[k].rtn);
+		
+		ik_chain_solve_fabrik(&chain, target, &opts, 0);
+		ik_chain_fx_solve_fabrik(&fx, vec3x_from_real(target), &opts_fx, 0);
+		
+		for (int k = 0; k < chain.num_nodes; k++) {
+			vec3f p = vec3x_to_real(fx.nodes[k].pos);
+			double e = mag3f(sub3f(p, chain.nodes[k].pos));
+			if (e > pos_err) pos_err = e;
+			
+			if (k == 0) continue;
+			double l = mag3f(sub3f(p, vec3x_to_real(fx.nodes[k - 1].pos)));
+			if (fabs(l - chain.nodes[k].length) > length_err) length_err = fabs(l - chain.nodes[k].length);
+		}
+	}
+	
+	__test_check("ik_chain_fx_solve_fabrik positions", pos_err, FX_POS_BOUND);
+	__test_check("ik_chain_fx_solve_fabrik bone lengths", length_err, FX_LENGTH_BOUND);
+	
+	ik_chain_fx_free(&fx);
+	return __test_failed;
+}
@@ -0,0 +1,97 @@
+/* tests of the damage tracking and presenting of inc/linuxfb.h on the
+ * headless memory backend: the demo scene is drawn both into the secondary
+ * buffer and, from scratch, into a reference image, and the displayed page
+ * has to equal the reference after every presented frame. frames are
+ * presented with `fb_swap` and every few frames with `fb_copy` (drawing on
+ * top of the last frame), in copy mode, flip mode and on the present thread.
+ * returns non-zero if a page differs.
+ *
+ *     make test_frames */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define FRAMES_COUNT 40
+#define FRAMES_XRES 640
+#define FRAMES_YRES 480
+#define FRAMES_LINE (FRAMES_XRES * 4 + 64) // rows padded like some drivers do
+
+enum {FRAMES_COPY, FRAMES_FLIP, FRAMES_ASYNC};
+static const char* __frames_modes[] = {"copy", "flip", "async"};
+
+static char __frames_ref[FRAMES_YRES * FRAMES_LINE];
+static rgbx32* __frames_ref_rows[FRAMES_YRES];
+
+/* draws the demo scene into the reference image, marking a scratch tile map */
+static void __frames_draw_ref(struct ik_chain* _chain, vec3f _target) {
+	rgbx32** rows = sbuf;
+	uint8_t* damage = fb_damage;
+	static uint8_t scratch[((FRAMES_XRES + FB_TILE - 1) >> FB_TILE_SHIFT) * ((FRAMES_YRES + FB_TILE - 1) >> FB_TILE_SHIFT)];
+	
+	sbuf = __frames_ref_rows;
+	fb_damage = scratch;
+	ik_draw_demo(_chain, _target);
+	sbuf = rows;
+	fb_damage = damage;
+}
+
+/* tells if the displayed page holds the reference image */
+static int __frames_match(void) {
+	char* front = __fb_front();
+	for (int y = 0; y < FRAMES_YRES; y++)
+		if (memcmp(front + y * fb_finfo.line_length, __frames_ref + y * FRAMES_LINE, FRAMES_XRES * 4)) return 0;
+	
+	return 1;
+}
+
+int main(void) {
+	int failed = 0;
+	
+	for (int y = 0; y < FRAMES_YRES; y++) __frames_ref_rows[y] = (rgbx32*) (__frames_ref + y * FRAMES_LINE);
+	
+	for (int mode = FRAMES_COPY; mode <= FRAMES_ASYNC; mode++) {
+		struct ik_chain chain;
+		int bad = -1;
+		
+		fb_use_memory(FRAMES_XRES, FRAMES_YRES, FRAMES_LINE, 0);
+		fb_mode = mode == FRAMES_FLIP ? FB_FLIP : FB_COPY;
+		if (fb_init(0)) XERR("failed to set up the memory screen!", ERROR_FAILED_ALLOCATE);
+		if (mode == FRAMES_ASYNC && fb_async_start() == -1) XERR("failed to start the present thread!", ERROR_FAILED_ALLOCATE);
+		if (ik_make_chain(&chain, 100, 3) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+		
+		// whatever the console left on the screen has to go
+		memset(fb_pbuf, 0x55, fb_finfo.smem_len);
+		memset(__frames_ref, 0, sizeof(__frames_ref));
+		
+		for (int f = 0; f < FRAMES_COUNT && bad == -1; f++) {
+			vec3f target = {100 + 150 * cos(f * 0.3), 80 + 120 * sin(f * 0.5), 0};
+			int keep = f % 5 == 4;
+			
+			ik_chain_solve_fabrik_warm(&chain, target, 0, 0);
+			ik_draw_demo(&chain, target);
+			__frames_draw_ref(&chain, target);
+			
+			if (keep) fb_copy();
+			else fb_swap();
+			
+			// the present thread is checked once it has shown the last frame
+			if (mode != FRAMES_ASYNC && !__frames_match()) bad = f;
+			if (!keep) memset(__frames_ref, 0, sizeof(__frames_ref));
+		}
+		
+		// stopping presents the last frame handed over
+		if (mode == FRAMES_ASYNC) {
+			fb_async_stop();
+			if (!__frames_match()) bad = FRAMES_COUNT - 1;
+		}
+		
+		if (bad == -1) printf("ok   %s: %d frames match a full redraw\n", __frames_modes[mode], FRAMES_COUNT);
+		else printf("FAIL %s: frame %d differs from a full redraw\n", __frames_modes[mode], bad);
+		if (bad != -1) failed = 1;
+		
+		fb_cleanup();
+		free(chain.nodes);
+	}
+	
+	return failed;
+}
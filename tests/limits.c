@@ -0,0 +1,119 @@
+/* tests of the elliptical joint limit. clamped vectors have to land on the
+ * ellipse, vectors inside it have to be left alone, vectors straight behind
+ * the axis have to come back finite, and FABRIK has to keep every bone of a
+ * chain with elliptical limits inside them. also checks that the limits are
+ * kept out of the nodes. returns non-zero if a check fails.
+ *
+ *     make test_limits */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define LIMITS_VECTORS 2000
+#define LIMITS_TARGETS 200
+#define LIMITS_BOUND 0.001 // of the ellipse equation of a clamped vector
+
+static int __test_failed = 0;
+static unsigned __test_seed = 1;
+
+static real __test_rand(void) {
+	__test_seed = __test_seed * 1103515245 + 12345;
+	return (real) ((__test_seed >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+static void __test_report(const char* _name, int _ok, const char* _fmt, double _value) {
+	printf("%s %s: ", _ok ? "ok  " : "FAIL", _name);
+	printf(_fmt, _value);
+	printf("\n");
+	if (!_ok) __test_failed = 1;
+}
+
+static vec3f __test_dir(void) {
+	return norm3f((vec3f) {__test_rand() - 0.5, __test_rand() - 0.5, __test_rand() - 0.5});
+}
+
+/* random axes, ups and vectors against a 40 by 15 degree ellipse */
+static void __test_clamp(void) {
+	struct ik_limit limit = {.type = IK_LIMIT_ELLIPSE, .aperture_y = PI/12};
+	real boundary = 0, moved = 0;
+	int inside = 0, outside = 0, finite = 1;
+	
+	__ik_update_limit(&limit, 2*PI/9);
+	
+	for (int i = 0; i < LIMITS_VECTORS; i++) {
+		vec3f axis = __test_dir(), v = __test_dir();
+		limit.up = __test_dir();
+		
+		vec3f u = __ik_swing_dir(axis, limit.up), w = cross3f(axis, u);
+		real ea = dot3f(v, u) * limit.cot_ap, eb = dot3f(v, w) * limit.cot_ap_y, c = dot3f(v, axis);
+		vec3f clamped = __ik_clamp_vector_to_limit(axis, &limit, v);
+		
+		if (c > 0 && ea * ea + eb * eb <= c * c) {
+			// inside, must come back as it was
+			real d = mag3f(sub3f(clamped, v));
+			if (d > moved) moved = d;
+			inside++;
+			continue;
+		}
+		
+		// outside, must land on the ellipse: (a cot(ap))^2 + (b cot(ap_y))^2 = c^2
+		ea = dot3f(clamped, u) * limit.cot_ap, eb = dot3f(clamped, w) * limit.cot_ap_y, c = dot3f(clamped, axis);
+		real e = fabs(ea * ea + eb * eb - c * c);
+		if (!(c > 0) || !(e <= boundary)) boundary = c > 0 ? e : INFINITY;
+		outside++;
+	}
+	
+	__test_report("vectors inside are kept", moved == 0 && inside > 0, "%g", moved);
+	__test_report("clamped vectors are on the ellipse", boundary < LIMITS_BOUND && outside > 0, "%g", boundary);
+	
+	// straight behind the axis, with `up` along the axis and across it
+	vec3f axis = {0, 0, 1};
+	vec3f ups[] = {{0, 0, 1}, {1, 0, 0}, {0, 1, 1}};
+	for (int i = 0; i < 3; i++) {
+		limit.up = ups[i];
+		vec3f clamped = __ik_clamp_vector_to_limit(axis, &limit, (vec3f) {0, 0, -1});
+		if (!isfinite(clamped.x) || !isfinite(clamped.y) || !isfinite(clamped.z) ||
+			!__ik_within_limit(axis, &limit, clamped, LIMITS_BOUND)) finite = 0;
+	}
+	
+	__test_report("vectors behind the axis", finite, "%g", finite);
+}
+
+/* FABRIK on a chain whose every joint has an ellipse */
+static void __test_fabrik(void) {
+	struct ik_chain chain;
+	real worst = 0;
+	
+	if (ik_make_chain(&chain, 8, 40) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+	
+	for (int k = 0; k < chain.num_nodes; k++) {
+		chain.limits[k].type = IK_LIMIT_ELLIPSE;
+		chain.limits[k].aperture_y = PI/16;
+		chain.limits[k].up = (vec3f) {0, k % 2, 1 - k % 2};
+	}
+	ik_chain_update_limits(&chain);
+	
+	for (int i = 0; i < LIMITS_TARGETS; i++) {
+		ik_chain_solve_fabrik(&chain, mul3f(__test_dir(), 320 * __test_rand()), 0, 0);
+		
+		// how far (in the ellipse equation) the worst bone is outside its limit
+		int last = chain.num_nodes - 1;
+		for (int k = last; k > 0; k--) {
+			vec3f axis = k == last ? chain.rtn : chain.nodes[k + 1].rtn;
+			struct ik_limit* limit = k == last ? &chain.limit : &chain.limits[k + 1];
+			for (real slack = worst; !__ik_within_limit(axis, limit, chain.nodes[k].rtn, slack); )
+				worst = slack = slack ? 2 * slack : 0.0000001;
+		}
+	}
+	
+	__test_report("fabrik keeps the ellipses", worst < LIMITS_BOUND, "%g", worst);
+	free(chain.nodes);
+}
+
+int main() {
+	__test_report("node size", sizeof(struct ik_node) == 8 * sizeof(real), "%g bytes", sizeof(struct ik_node));
+	__test_clamp();
+	__test_fabrik();
+	
+	return __test_failed;
+}
@@ -0,0 +1,106 @@
+/* error and throughput of the math tiers of inc/linalg.h against libm.
+ * every tier's scalar functions are measured whatever `LINALG_MATH_TIER`
+ * is, the batched ones (rsqrt_n, acos_n, sincos_n) in the configured tier.
+ * returns non-zero if an error goes past the documented bound (plus a few
+ * units of rounding in float builds).
+ *
+ *     make test_math */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define MATH_SAMPLES (1 << 20)
+#define MATH_EPS (sizeof(real) == 4 ? 1.2e-7 : 2.2e-16)
+
+static real __math_in[3][MATH_SAMPLES]; // rsqrt, acos and sincos inputs
+static real __math_out[2][MATH_SAMPLES];
+static volatile real __math_sink;
+
+struct math_tier {
+	const char* name;
+	real (*rsqrt)(real);
+	real (*acos)(real);
+	void (*sincos)(real, real*, real*);
+	double bound[3]; // documented error of rsqrt (rel.), acos and sincos
+};
+
+static struct math_tier __math_tiers[] = {
+	{"exact", rsqrt_exact, acos_exact, sincos_exact, {0, 0, 0}},
+	{"fast", rsqrt_fast, acos_fast, sincos_fast, {4.6e-6, 6.8e-5, 3.2e-7}},
+	{"fastest", rsqrt_fastest, acos_fastest, sincos_fastest, {1.8e-3, 3.3e-3, 3.7e-5}},
+};
+
+/* nanoseconds per sample that the statement after `NS` takes (the best of
+ * `MATH_RUNS` runs) */
+#define MATH_RUNS 5
+#define MATH_TIME(NS, ...) { \
+	NS = 1e9; \
+	for (int run = 0; run < MATH_RUNS; run++) { \
+		uint64_t start = __tp_now_ns(); \
+		__VA_ARGS__; \
+		NS = fmin(NS, (double) (__tp_now_ns() - start) / MATH_SAMPLES); \
+	} \
+}
+
+int main(void) {
+	int failed = 0;
+	uint32_t seed = 12345;
+	
+	// reciprocal square roots of 1e-6 to 1e6, acos of [-1, 1] and sincos of
+	// +-100 radians
+	for (int i = 0; i < MATH_SAMPLES; i++) {
+		seed = seed * 1664525 + 1013904223;
+		double u = (double) (seed >> 8) / (1 << 24);
+		__math_in[0][i] = pow(10, 12 * u - 6);
+		__math_in[1][i] = 2 * u - 1;
+		__math_in[2][i] = 200 * u - 100;
+	}
+	
+	printf("%s build, tier %d\n\n", sizeof(real) == 4 ? "float" : "double", LINALG_MATH_TIER);
+	printf("           RSQRT (rel.)        ACOS (rad)          SINCOS (abs.)\n");
+	printf("           error    ns/call    error    ns/call    error    ns/call\n");
+	
+	for (int t = 0; t < 3; t++) {
+		struct math_tier* tier = &__math_tiers[t];
+		double err[3] = {0, 0, 0}, ns[3];
+		real sum = 0, s, c;
+		
+		for (int i = 0; i < MATH_SAMPLES; i++) {
+			double x = __math_in[0][i], want = 1 / sqrt(x);
+			err[0] = fmax(err[0], fabs(tier->rsqrt(x) - want) / want);
+			
+			x = __math_in[1][i];
+			err[1] = fmax(err[1], fabs(tier->acos(x) - acos(x)));
+			
+			x = __math_in[2][i];
+			tier->sincos(x, &s, &c);
+			err[2] = fmax(err[2], fmax(fabs(s - sin((real) x)), fabs(c - cos((real) x))));
+		}
+		
+		MATH_TIME(ns[0], for (int i = 0; i < MATH_SAMPLES; i++) sum += tier->rsqrt(__math_in[0][i]));
+		MATH_TIME(ns[1], for (int i = 0; i < MATH_SAMPLES; i++) sum += tier->acos(__math_in[1][i]));
+		MATH_TIME(ns[2], for (int i = 0; i < MATH_SAMPLES; i++) tier->sincos(__math_in[2][i], &s, &c), sum += s + c);
+		__math_sink = sum;
+		
+		printf("%-9s", tier->name);
+		for (int f = 0; f < 3; f++) printf("  %-8.3g %-9.2f", err[f], ns[f]);
+		printf("\n");
+		
+		// the exact tier is libm itself, floats round the polynomials on top
+		for (int f = 0; f < 3 && t > 0; f++) {
+			double bound = tier->bound[f] + 8 * MATH_EPS * (f == 1 ? PI : 1);
+			if (err[f] > bound) {
+				printf("FAIL %s: error %g past its bound of %g\n", tier->name, err[f], bound);
+				failed = 1;
+			}
+		}
+	}
+	
+	double ns[3];
+	MATH_TIME(ns[0], rsqrt_n(__math_out[0], __math_in[0], MATH_SAMPLES));
+	MATH_TIME(ns[1], acos_n(__math_out[0], __math_in[1], MATH_SAMPLES));
+	MATH_TIME(ns[2], sincos_n(__math_out[0], __math_out[1], __math_in[2], MATH_SAMPLES));
+	printf("batched    %-8s %-9.2f  %-8s %-9.2f  %-8s %-9.2f\n", "", ns[0], "", ns[1], "", ns[2]);
+	
+	return failed;
+}
@@ -0,0 +1,107 @@
+/* tests of the work-stealing thread pool (see inc/thread_pool.h). every job
+ * submitted has to run exactly once per `tp_wait`, a frame whose jobs all
+ * land on one worker's deque has to be shared out by stealing, and the
+ * per-worker statistics and `tp_utilisation` have to add up to what ran.
+ * returns non-zero if a check fails.
+ *
+ *     make test_pool */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define POOL_WORKERS 4
+#define POOL_JOBS 256
+#define POOL_FRAMES 50
+#define POOL_SLOW_NS 500000 // spin of a slow job
+
+static int __test_failed = 0;
+static _Atomic int __pool_runs[POOL_JOBS];
+static int __pool_slow; // jobs with an index that is a multiple of this are slow
+
+static void __test_report(const char* _name, int _ok, const char* _fmt, double _value) {
+	printf("%s %s: ", _ok ? "ok  " : "FAIL", _name);
+	printf(_fmt, _value);
+	printf("\n");
+	if (!_ok) __test_failed = 1;
+}
+
+static void __pool_job(void* _arg) {
+	int i = (int) (intptr_t) _arg;
+	atomic_fetch_add_explicit(&__pool_runs[i], 1, memory_order_relaxed);
+	
+	if (__pool_slow && i % __pool_slow == 0)
+		for (uint64_t start = __tp_now_ns(); __tp_now_ns() - start < POOL_SLOW_NS; );
+}
+
+/* submits `_num_jobs` jobs, runs them and checks that each ran once and that
+ * the statistics account for them. (returns the steals of the frame) */
+static int __pool_frame(struct tp_pool* _pool, int _num_jobs, int* _once, int* _stats) {
+	for (int i = 0; i < _num_jobs; i++) atomic_store(&__pool_runs[i], 0);
+	for (int i = 0; i < _num_jobs; i++)
+		if (tp_submit(_pool, __pool_job, (void*) (intptr_t) i) == -1) *_once = 0;
+	
+	tp_wait(_pool);
+	
+	for (int i = 0; i < _num_jobs; i++)
+		if (atomic_load(&__pool_runs[i]) != 1) *_once = 0;
+	
+	uint64_t busy = 0;
+	int jobs = 0, steals = 0;
+	double utilisation = 0;
+	for (int w = 0; w < _pool->num_workers; w++) {
+		struct tp_stats* s = &_pool->workers[w].stats;
+		busy += s->busy_ns;
+		jobs += s->jobs;
+		steals += s->steals;
+		utilisation += tp_utilisation(_pool, w);
+		if (s->steals > s->jobs || tp_utilisation(_pool, w) > 1.001) *_stats = 0;
+	}
+	
+	// a worker is never busy for longer than the frame, so neither are all of
+	// them together for longer than the frame times their count
+	if (jobs != _num_jobs || busy > _pool->frame_ns * _pool->num_workers) *_stats = 0;
+	if (_pool->frame_ns && fabs(utilisation - (double) busy / _pool->frame_ns) > 0.000001) *_stats = 0;
+	if (!_num_jobs && (_pool->frame_ns || utilisation)) *_stats = 0;
+	
+	return steals;
+}
+
+int main() {
+	struct tp_pool pool;
+	int once = 1, stats = 1, steals = 0;
+	
+	if (tp_init(&pool, POOL_WORKERS, POOL_JOBS) == -1) XERR("failed to start the thread pool!", ERROR_FAILED_ALLOCATE);
+	
+	// quick jobs of every count, frame after frame
+	for (int f = 0; f < POOL_FRAMES; f++) __pool_frame(&pool, f * POOL_JOBS / POOL_FRAMES, &once, &stats);
+	__pool_frame(&pool, POOL_JOBS, &once, &stats);
+	__test_report("every job runs once", once, "%g frames", POOL_FRAMES + 1);
+	__test_report("statistics add up", stats, "%g", stats);
+	
+	// the slow jobs are all dealt to worker 0, the others have to steal them
+	__pool_slow = POOL_WORKERS;
+	once = stats = 1;
+	steals = __pool_frame(&pool, 16 * POOL_WORKERS, &once, &stats);
+	__test_report("slow jobs run once", once && stats, "%g", once && stats);
+	__test_report("slow jobs are stolen", steals > 0, "%g steals", steals);
+	
+	double utilisation = 0;
+	for (int w = 0; w < POOL_WORKERS; w++) utilisation += tp_utilisation(&pool, w);
+	__test_report("busy frame is utilised", utilisation > 0.5, "%g", utilisation);
+	__pool_slow = 0;
+	
+	// the pool was sized for POOL_JOBS jobs, one more is refused and the
+	// others still run once
+	once = 1;
+	for (int i = 0; i < POOL_JOBS; i++) atomic_store(&__pool_runs[i], 0);
+	for (int i = 0; i < POOL_JOBS; i++)
+		if (tp_submit(&pool, __pool_job, (void*) (intptr_t) i) == -1) once = 0;
+	int refused = tp_submit(&pool, __pool_job, 0) == -1;
+	tp_wait(&pool);
+	for (int i = 0; i < POOL_JOBS; i++)
+		if (atomic_load(&__pool_runs[i]) != 1) once = 0;
+	__test_report("full queue refuses a job", refused && once, "%g", refused && once);
+	
+	tp_destroy(&pool);
+	return __test_failed;
+}
@@ -0,0 +1,139 @@
+/* round trips of every pose encoding of inc/ik_pose.h on a 30 bone chain of
+ * 600 units whose root sits away from the origin, through memory and through
+ * a pose file. the lossless encodings have to restore the pose exactly, the
+ * others within POSE_BOUND, and files with an unknown encoding have to be
+ * refused. returns non-zero if a check fails.
+ *
+ *     make test_pose */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define POSE_BONES 30
+#define POSE_LENGTH 20
+#define POSE_FRAMES 50
+#define POSE_BOUND 0.01 // in units, for the lossy encodings
+#define POSE_PATH "/tmp/ik_test_pose"
+
+static int __test_failed = 0;
+static unsigned __test_seed = 1;
+
+static real __test_rand(void) {
+	__test_seed = __test_seed * 1103515245 + 12345;
+	return (real) ((__test_seed >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+static void __test_report(const char* _name, int _ok, const char* _fmt, double _value) {
+	printf("%s %s: ", _ok ? "ok  " : "FAIL", _name);
+	printf(_fmt, _value);
+	printf("\n");
+	if (!_ok) __test_failed = 1;
+}
+
+/* solves `_chain` towards a random target, its root moved to `_root` */
+static void __test_pose(struct ik_chain* _chain, vec3f _root) {
+	vec3f shift = sub3f(_root, _chain->nodes[_chain->num_nodes - 1].pos);
+	for (int k = 0; k < _chain->num_nodes; k++) _chain->nodes[k].pos = add3f(_chain->nodes[k].pos, shift);
+	
+	vec3f dir = norm3f((vec3f) {__test_rand() - 0.5, __test_rand() - 0.5, __test_rand() - 0.5});
+	ik_chain_solve_fabrik(_chain, add3f(_root, mul3f(dir, POSE_BONES * POSE_LENGTH * __test_rand())), 0, 0);
+}
+
+/* largest difference between the nodes of two chains */
+static real __test_pose_error(struct ik_chain* _a, struct ik_chain* _b) {
+	real worst = 0;
+	for (int k = 0; k < _a->num_nodes; k++) {
+		real d = mag3f(sub3f(_a->nodes[k].pos, _b->nodes[k].pos));
+		real r = mag3f(sub3f(_a->nodes[k].rtn, _b->nodes[k].rtn));
+		if (d > worst) worst = d;
+		if (r > worst) worst = r;
+	}
+	
+	return worst;
+}
+
+static void __test_encoding(int _encoding, const char* _name, real _bound) {
+	struct ik_chain chain, copy;
+	struct ik_pose_file file;
+	real memory = 0, stored = 0;
+	vec3f root = {300, -200, 100};
+	
+	if (ik_make_chain(&chain, POSE_BONES, POSE_LENGTH) == -1 || ik_make_chain(&copy, POSE_BONES, POSE_LENGTH) == -1)
+		XERR("failed to allocate the chains!", ERROR_FAILED_ALLOCATE);
+	
+	void* frame = malloc(ik_pose_frame_size(_encoding, chain.num_nodes));
+	if (!frame) XERR("failed to allocate the frame!", ERROR_FAILED_ALLOCATE);
+	
+	if (ik_pose_file_create(&file, POSE_PATH, _encoding, chain.num_nodes, POSE_FRAMES) == -1) {
+		printf("FAIL %s: could not create the pose file\n", _name);
+		__test_failed = 1;
+		return;
+	}
+	
+	// every frame through memory, and stored in the file
+	__test_seed = 1;
+	for (int f = 0; f < POSE_FRAMES; f++) {
+		__test_pose(&chain, root);
+		ik_pose_encode(&chain, _encoding, frame);
+		ik_pose_decode(&copy, _encoding, frame);
+		if (__test_pose_error(&chain, &copy) > memory) memory = __test_pose_error(&chain, &copy);
+		ik_pose_file_store(&file, f, &chain);
+	}
+	
+	ik_pose_file_close(&file);
+	
+	// the same poses again, loaded from the file
+	__test_seed = 1;
+	ik_reset_chain(&chain);
+	if (ik_pose_file_open(&file, POSE_PATH, 0) == -1) {
+		printf("FAIL %s: could not open the pose file\n", _name);
+		__test_failed = 1;
+	}
+	else {
+		for (int f = 0; f < POSE_FRAMES; f++) {
+			__test_pose(&chain, root);
+			ik_pose_file_load(&file, f, &copy);
+			if (__test_pose_error(&chain, &copy) > stored) stored = __test_pose_error(&chain, &copy);
+		}
+		
+		ik_pose_file_close(&file);
+	}
+	
+	char name[64];
+	snprintf(name, sizeof(name), "%s, memory", _name);
+	__test_report(name, memory <= _bound, "%g", memory);
+	snprintf(name, sizeof(name), "%s, file", _name);
+	__test_report(name, stored <= _bound, "%g", stored);
+	
+	free(frame);
+	free(chain.nodes);
+	free(copy.nodes);
+}
+
+/* unknown encodings are refused by create and by open */
+static void __test_unknown(void) {
+	struct ik_pose_file file;
+	
+	__test_report("unknown encoding, frame size", ik_pose_frame_size(IK_POSE_QUANT + 1, 4) == 0, "%g bytes", (double) ik_pose_frame_size(IK_POSE_QUANT + 1, 4));
+	int ret = ik_pose_file_create(&file, POSE_PATH, 7, 4, 1);
+	__test_report("unknown encoding, create", ret == -1, "returned %g", ret);
+	
+	if (ik_pose_file_create(&file, POSE_PATH, IK_POSE_REAL, 4, 1) == -1) XERR("failed to create the pose file!", ERROR_FAILED_ALLOCATE);
+	file.header->encoding = 7;
+	ik_pose_file_close(&file);
+	
+	ret = ik_pose_file_open(&file, POSE_PATH, 0);
+	__test_report("unknown encoding, open", ret == -1, "returned %g", ret);
+	if (ret == 0) ik_pose_file_close(&file);
+}
+
+int main() {
+	__test_encoding(IK_POSE_NODES, "nodes", 0);
+	__test_encoding(IK_POSE_REAL, "real", 0);
+	__test_encoding(IK_POSE_HALF, "half", POSE_BOUND);
+	__test_encoding(IK_POSE_QUANT, "quant", POSE_BOUND);
+	__test_unknown();
+	
+	unlink(POSE_PATH);
+	return __test_failed;
+}
@@ -0,0 +1,168 @@
+/* accuracy of the float build against the double one. built as double it
+ * writes the pose of every frame to stdout, built with `LINALG_FLOAT` it
+ * reads them from stdin and compares its own poses with them, solved frame
+ * after frame both from its own last pose (drift) and from the double pose
+ * of the frame before (the error of a single solve). returns non-zero if an
+ * error goes past its bound.
+ *
+ *     make test_precision */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define PRECISION_FRAMES 200
+#define PRECISION_REACH 300 // length of every chain, split into equal bones
+
+/* bounds on the largest distance between a float and a double node over
+ * all frames. a single solve stays within `solve` of the double one. warm
+ * solves follow the targets from slightly different poses, which long
+ * chains do not forget: `drift` bounds how far apart the two poses get over
+ * the frames and `effector` how different their distances to the target
+ * are. FABRIK converges on these targets, so float only costs rounding.
+ * CCD stops after its 10 iterations well short of the target, and such an
+ * unfinished pose depends on the rounding of every step, most of all near
+ * full extension (the 2 bone chain reaching 295 of its 300 units): up to a
+ * tenth of a unit per solve. the poses of long CCD chains then wander apart
+ * over the frames (a 100 bone chain has many poses for one effector
+ * position), so their drift is only bounded loosely. */
+struct precision_case {
+	short bones;
+	int solver;
+	double solve, drift, effector;
+};
+
+static struct precision_case __precision_cases[] = {
+	{2, IK_REPLAY_FABRIK, 0.001, 0.001, 0.001},
+	{8, IK_REPLAY_FABRIK, 0.001, 0.002, 0.001},
+	{32, IK_REPLAY_FABRIK, 0.001, 0.001, 0.001},
+	{100, IK_REPLAY_FABRIK, 0.005, 0.1, 0.01},
+	{2, IK_REPLAY_CCD, 0.2, 0.5, 0.2},
+	{8, IK_REPLAY_CCD, 0.5, 2, 0.2},
+	{32, IK_REPLAY_CCD, 0.5, 3, 0.2},
+	{100, IK_REPLAY_CCD, 0.5, 20, 1},
+};
+
+#define PRECISION_CASES (int) (sizeof(__precision_cases) / sizeof(__precision_cases[0]))
+
+/* internal function that returns where the effector of a chain of `_bones`
+ * bones ends up if every joint bends by up to 80% of its limit, in a
+ * direction and by an amount that wander with the frame `_f`. the targets
+ * are reachable, so the solvers compare converged poses rather than how
+ * they give up on a target they cannot reach. */
+static vec3f __precision_target(int _bones, int _f) {
+	real length = (real) PRECISION_REACH / _bones;
+	vec3f pos = {0, 0, 0}, dir = {1, 0, 0};
+	
+	for (int k = 0; k < _bones; k++) {
+		real limit = k == 0 ? PI / 2 : PI / 6;
+		real bend = 0.8 * limit * sin(_f * 0.03 + k * 0.7);
+		real phi = _f * 0.02 + k * 1.3;
+		
+		vec3f axis = norm3f(cross3f(dir, (vec3f) {0, cos(phi), sin(phi)}));
+		dir = norm3f(qrot(make_qrot(axis, bend), dir));
+		pos = add3f(pos, mul3f(dir, length));
+	}
+	
+	return pos;
+}
+
+static void __precision_solve(struct ik_chain* _chain, int _solver, vec3f _target) {
+	if (_solver == IK_REPLAY_CCD) ik_chain_solve_ccd(_chain, _target, 0.5, 0, 0);
+	else ik_chain_solve_fabrik(_chain, _target, 0, 0);
+}
+
+static void __precision_chain(struct ik_chain* _chain, int _case) {
+	short bones = __precision_cases[_case].bones;
+	if (ik_make_chain(_chain, bones, (real) PRECISION_REACH / bones) == -1)
+		XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+}
+
+#ifndef LINALG_FLOAT
+
+int main(void) {
+	for (int c = 0; c < PRECISION_CASES; c++) {
+		struct precision_case* pc = &__precision_cases[c];
+		struct ik_chain chain;
+		__precision_chain(&chain, c);
+		
+		for (int f = 0; f < PRECISION_FRAMES; f++) {
+			__precision_solve(&chain, pc->solver, __precision_target(pc->bones, f));
+			
+			for (int k = 0; k < chain.num_nodes; k++) {
+				struct ik_node* n = &chain.nodes[k];
+				double pose[6] = {n->pos.x, n->pos.y, n->pos.z, n->rtn.x, n->rtn.y, n->rtn.z};
+				if (fwrite(pose, sizeof(pose), 1, stdout) != 1) XERR("failed to write the poses!", ERROR_FAILED_ALLOCATE);
+			}
+		}
+		
+		free(chain.nodes);
+	}
+	
+	return 0;
+}
+
+#else
+
+static const char* __precision_solvers[] = {"fabrik", "ccd"};
+
+int main(void) {
+	int failed = 0;
+	
+	printf("bones  solver   solve      drift      effector\n");
+	
+	for (int c = 0; c < PRECISION_CASES; c++) {
+		struct precision_case* pc = &__precision_cases[c];
+		
+		struct ik_chain drift, seeded;
+		__precision_chain(&drift, c);
+		__precision_chain(&seeded, c);
+		
+		double (*pose)[6] = malloc(drift.num_nodes * sizeof(*pose));
+		if (!pose) XERR("failed to allocate the poses!", ERROR_FAILED_ALLOCATE);
+		
+		double solve = 0, drifted = 0, effector = 0;
+		for (int f = 0; f < PRECISION_FRAMES; f++) {
+			vec3f target = __precision_target(pc->bones, f);
+			
+			// `seeded` starts from the double pose of the last frame
+			if (f > 0) {
+				for (int k = 0; k < seeded.num_nodes; k++)
+					seeded.nodes[k].pos = (vec3f) {pose[k][0], pose[k][1], pose[k][2]},
+					seeded.nodes[k].rtn = (vec3f) {pose[k][3], pose[k][4], pose[k][5]};
+				ik_chain_invalidate(&seeded);
+			}
+			
+			__precision_solve(&seeded, pc->solver, target);
+			__precision_solve(&drift, pc->solver, target);
+			
+			if (fread(pose, sizeof(*pose), drift.num_nodes, stdin) != (size_t) drift.num_nodes) {
+				printf("FAIL: the double poses ended early, run as `tests/precision_double | tests/precision_float`\n");
+				return 1;
+			}
+			
+			for (int k = 0; k < drift.num_nodes; k++) {
+				double dx = drift.nodes[k].pos.x - pose[k][0], dy = drift.nodes[k].pos.y - pose[k][1], dz = drift.nodes[k].pos.z - pose[k][2];
+				drifted = fmax(drifted, sqrt(dx * dx + dy * dy + dz * dz));
+				
+				dx = seeded.nodes[k].pos.x - pose[k][0], dy = seeded.nodes[k].pos.y - pose[k][1], dz = seeded.nodes[k].pos.z - pose[k][2];
+				solve = fmax(solve, sqrt(dx * dx + dy * dy + dz * dz));
+			}
+			
+			// effector distances to the target
+			double dx = pose[0][0] - target.x, dy = pose[0][1] - target.y, dz = pose[0][2] - target.z;
+			effector = fmax(effector, fabs(ik_chain_error(&drift, target) - sqrt(dx * dx + dy * dy + dz * dz)));
+		}
+		
+		int bad = solve > pc->solve || drifted > pc->drift || effector > pc->effector;
+		printf("%-6d %-8s %-10.3g %-10.3g %-10.3g%s\n", pc->bones, __precision_solvers[pc->solver], solve, drifted, effector, bad ? " FAIL" : "");
+		if (bad) failed = 1;
+		
+		free(pose);
+		free(drift.nodes);
+		free(seeded.nodes);
+	}
+	
+	return failed;
+}
+
+#endif
@@ -0,0 +1,61 @@
+/* benchmark of the renderer on the headless memory backend (`fb_use_memory`):
+ * the demo scene of skeleton.c (a 100 bone chain following a moving target)
+ * on a 1920 x 1080 screen, presented in copy mode, flip mode and on the
+ * present thread (copy mode). reported are the time per frame as the render
+ * loop sees it and the time spent in `fb_swap`.
+ *
+ *     make bench_render */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define RENDER_FRAMES 2000
+
+enum {RENDER_COPY, RENDER_FLIP, RENDER_ASYNC};
+static const char* __render_modes[] = {"copy", "flip", "async"};
+
+/* target of frame `_f`, the path of a mouse drawing loops */
+static vec3f __render_target(int _f) {
+	return (vec3f) {200 + 250 * cos(_f * 0.013), 150 + 200 * sin(_f * 0.021), 40 * sin(_f * 0.007)};
+}
+
+int main(void) {
+	printf("mode   us/frame  us in fb_swap  frames shown\n");
+	
+	for (int mode = RENDER_COPY; mode <= RENDER_ASYNC; mode++) {
+		struct ik_chain chain;
+		uint64_t total = 0, swap = 0;
+		
+		fb_use_memory(1920, 1080, 0, 0);
+		fb_mode = mode == RENDER_FLIP ? FB_FLIP : FB_COPY;
+		if (fb_init(0)) XERR("failed to set up the memory screen!", ERROR_FAILED_ALLOCATE);
+		if (mode == RENDER_ASYNC && fb_async_start() == -1) XERR("failed to start the present thread!", ERROR_FAILED_ALLOCATE);
+		if (ik_make_chain(&chain, 100, 5) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+		
+		for (int f = 0; f < RENDER_FRAMES; f++) {
+			vec3f target = __render_target(f);
+			uint64_t start = __tp_now_ns();
+			
+			ik_chain_solve_fabrik_warm(&chain, target, 0, 0);
+			ik_draw_demo(&chain, target);
+			
+			uint64_t drawn = __tp_now_ns();
+			fb_swap();
+			uint64_t end = __tp_now_ns();
+			
+			total += end - start;
+			swap += end - drawn;
+		}
+		
+		fb_async_stop();
+		printf(
+			"%-6s %-9.1f %-14.1f %lu/%d\n", __render_modes[mode],
+			total / 1000.0 / RENDER_FRAMES, swap / 1000.0 / RENDER_FRAMES, fb_memory.frames, RENDER_FRAMES
+		);
+		
+		fb_cleanup();
+		free(chain.nodes);
+	}
+	
+	return 0;
+}
@@ -0,0 +1,47 @@
+/* replay test of the deterministic build (see inc/ik_replay.h). runs fixed
+ * target sequences through `ik_chain_solve_fabrik` and `ik_chain_solve_ccd`
+ * and compares the pose hashes with the ones every `IK_DETERMINISTIC` build
+ * of the same precision has to produce. returns non-zero on a mismatch.
+ *
+ *     make deterministic */
+
+#define IK_DETERMINISTIC
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define REPLAY_TARGETS 200
+
+/* expected hashes, double then float */
+#ifdef LINALG_FLOAT
+	#define REPLAY_FABRIK 0x17D1743B3AFE6D22ULL
+	#define REPLAY_CCD 0xFA33CF8011549334ULL
+#else
+	#define REPLAY_FABRIK 0x2E9233BDE7CDFB08ULL
+	#define REPLAY_CCD 0xEBB597C6A503C645ULL
+#endif
+
+int main(void) {
+	struct ik_chain chain;
+	vec3f targets[REPLAY_TARGETS];
+	int failed = 0;
+	
+	if (ik_make_chain(&chain, 100, 5) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+	
+	// integer targets, so the sequence itself cannot differ between machines
+	for (int i = 0; i < REPLAY_TARGETS; i++)
+		targets[i] = (vec3f) {(i * 37) % 301 - 150, (i * 53) % 241 - 120, (i * 11) % 81 - 40};
+	
+	struct {
+		const char* name;
+		int solver;
+		uint64_t want;
+	} runs[] = {{"fabrik", IK_REPLAY_FABRIK, REPLAY_FABRIK}, {"ccd", IK_REPLAY_CCD, REPLAY_CCD}};
+	
+	for (int r = 0; r < 2; r++) {
+		uint64_t hash = ik_chain_replay(&chain, targets, REPLAY_TARGETS, runs[r].solver, 0.5, 0);
+		printf("%s %s %s: %016llX\n", hash == runs[r].want ? "ok  " : "FAIL", sizeof(real) == 4 ? "float" : "double", runs[r].name, (unsigned long long) hash);
+		if (hash != runs[r].want) failed = 1;
+	}
+	
+	return failed;
+}
@@ -0,0 +1,80 @@
+/* tests of the lockstep FABRIK of inc/ik_simd.h against `ik_chain_solve_fabrik`.
+ * every lane stops iterating on its own, so it has to end in the pose and
+ * after the iterations of the scalar solve (lane 0 starts out solved). packs
+ * of the vector width and of a width without a vector path (solved lane by
+ * lane) are checked, each also with straight chains whose first forward step
+ * bends a joint exactly backwards. returns non-zero if a lane differs.
+ *
+ *     make test_simd */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define SIMD_BONES 16
+#define SIMD_BOUND 1e-9 // the kernels mirror the scalar math bit for bit
+#define SIMD_ODD_WIDTH 3 // never a vector width
+
+static int __test_failed = 0;
+
+/* solves a pack of `_width` chains of `_bones` bones and the same chains one
+ * by one. with `_backwards` the targets lie on the straight chains, so the
+ * joint below the effector has to fold back onto the bone before it */
+static void __test_pack(const char* _name, int _width, int _bones, int _backwards) {
+	struct ik_chain packed[IK_SIMD_MAX_WIDTH], scalar[IK_SIMD_MAX_WIDTH];
+	vec3f targets[IK_SIMD_MAX_WIDTH];
+	struct ik_solve_result pres[IK_SIMD_MAX_WIDTH], sres;
+	struct ik_pack pack;
+	
+	if (ik_pack_alloc(&pack, _bones + 1) == -1) XERR("failed to allocate the pack!", ERROR_FAILED_ALLOCATE);
+	
+	// targets of different difficulty, so the lanes converge after different
+	// numbers of iterations
+	for (int l = 0; l < _width; l++) {
+		if (ik_make_chain(&packed[l], _bones, 10) == -1 || ik_make_chain(&scalar[l], _bones, 10) == -1)
+			XERR("failed to allocate the chains!", ERROR_FAILED_ALLOCATE);
+		
+		if (_backwards) targets[l] = (vec3f) {5 + l, 0, 0};
+		else targets[l] = l ? (vec3f) {20 + 10 * l, 60 - 5 * l, l} : packed[0].nodes[0].pos;
+	}
+	
+	ik_pack_load(&pack, packed, _width);
+	ik_pack_solve_fabrik(&pack, targets, 0, pres);
+	ik_pack_store(&pack, packed);
+	
+	for (int l = 0; l < _width; l++) {
+		real diff = 0;
+		
+		ik_chain_solve_fabrik(&scalar[l], targets[l], 0, &sres);
+		for (int k = 0; k <= _bones; k++) {
+			real d = mag3f(sub3f(packed[l].nodes[k].pos, scalar[l].nodes[k].pos));
+			if (!(d <= diff)) diff = d; // keeps a nan
+		}
+		
+		int ok = pres[l].iterations == sres.iterations && diff <= SIMD_BOUND;
+		printf(
+			"%s %s, lane %d: %d iterations (scalar %d), pose off by %g\n",
+			ok ? "ok  " : "FAIL", _name, l, pres[l].iterations, sres.iterations, (double) diff
+		);
+		if (!ok) __test_failed = 1;
+		
+		free(packed[l].nodes);
+		free(scalar[l].nodes);
+	}
+	
+	ik_pack_free(&pack);
+}
+
+int main(void) {
+	int width = ik_simd_width();
+	
+	if (width == 1) printf("ok   no vector path on this machine\n");
+	else {
+		__test_pack("vector", width, SIMD_BONES, 0);
+		__test_pack("vector, folding back", width, 3, 1);
+	}
+	
+	__test_pack("lane by lane", SIMD_ODD_WIDTH, SIMD_BONES, 0);
+	__test_pack("lane by lane, folding back", SIMD_ODD_WIDTH, 3, 1);
+	
+	return __test_failed;
+}
@@ -0,0 +1,112 @@
+/* tests of the SoA chains of inc/ik_soa.h against the usual `struct
+ * ik_chain`s: from the same pose, FABRIK has to give the same pose bit for
+ * bit and CCD the same pose within SOA_BOUND, with the same iterations and
+ * results. CCD normalises the directions at other points in the two layouts,
+ * so this is built with the exact math tier, with the fast `RSQRT` the poses
+ * drift apart by about 1e-4 units an iteration. a round trip through the
+ * SoA layout has to bring the limits up to date. returns non-zero if a check
+ * fails.
+ *
+ *     make test_soa */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define SOA_TARGETS 200
+#define SOA_BOUND 1e-6 // in units, for CCD
+
+static int __test_failed = 0;
+static unsigned __test_seed = 1;
+
+static real __test_rand(void) {
+	__test_seed = __test_seed * 1103515245 + 12345;
+	return (real) ((__test_seed >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+static void __test_report(const char* _name, int _ok, const char* _fmt, double _value) {
+	printf("%s %s: ", _ok ? "ok  " : "FAIL", _name);
+	printf(_fmt, _value);
+	printf("\n");
+	if (!_ok) __test_failed = 1;
+}
+
+/* largest difference between the nodes of a chain and of a SoA chain */
+static real __test_difference(struct ik_chain* _chain, struct ik_chain_soa* _soa) {
+	real worst = 0;
+	for (int k = 0; k < _chain->num_nodes; k++) {
+		real d = mag3f(sub3f(_chain->nodes[k].pos, __ik_soa_pos(_soa, k)));
+		real r = mag3f(sub3f(_chain->nodes[k].rtn, __ik_soa_rtn(_soa, k)));
+		if (d > worst) worst = d;
+		if (r > worst) worst = r;
+	}
+	
+	return worst;
+}
+
+/* solves random targets with both layouts, each from the pose the chain
+ * had after the last one (`_ccd` selects CCD over FABRIK) */
+static void __test_solver(int _bones, int _ccd) {
+	struct ik_chain chain;
+	struct ik_chain_soa soa;
+	real worst = 0;
+	int mismatched = 0;
+	
+	if (ik_make_chain(&chain, _bones, 10) == -1) XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+	
+	__test_seed = 1;
+	for (int t = 0; t < SOA_TARGETS; t++) {
+		struct ik_solve_result res, res_soa;
+		vec3f dir = norm3f((vec3f) {__test_rand() - 0.5, __test_rand() - 0.5, __test_rand() - 0.5});
+		vec3f target = mul3f(dir, 10 * _bones * __test_rand());
+		
+		if (ik_chain_to_soa(&soa, &chain) == -1) XERR("failed to allocate the SoA chain!", ERROR_FAILED_ALLOCATE);
+		
+		int ret = _ccd ? ik_chain_solve_ccd(&chain, target, 1, 0, &res) : ik_chain_solve_fabrik(&chain, target, 0, &res);
+		int ret_soa = _ccd ? ik_soa_solve_ccd(&soa, target, 1, 0, &res_soa) : ik_soa_solve_fabrik(&soa, target, 0, &res_soa);
+		
+		if (ret != ret_soa || res.iterations != res_soa.iterations || fabs(res.error - res_soa.error) > SOA_BOUND) mismatched++;
+		if (__test_difference(&chain, &soa) > worst) worst = __test_difference(&chain, &soa);
+		ik_soa_free(&soa);
+	}
+	
+	char name[64];
+	snprintf(name, sizeof(name), "%s, %d bones, results", _ccd ? "ccd" : "fabrik", _bones);
+	__test_report(name, mismatched == 0, "%g mismatched", mismatched);
+	snprintf(name, sizeof(name), "%s, %d bones, pose", _ccd ? "ccd" : "fabrik", _bones);
+	__test_report(name, _ccd ? worst <= SOA_BOUND : worst == 0, "%g", worst);
+	
+	free(chain.nodes);
+}
+
+/* apertures changed in SoA layout reach the limits of the chain */
+static void __test_limits(void) {
+	struct ik_chain chain;
+	struct ik_chain_soa soa;
+	real worst = 0;
+	
+	if (ik_make_chain(&chain, 8, 10) == -1 || ik_chain_to_soa(&soa, &chain) == -1)
+		XERR("failed to allocate the chains!", ERROR_FAILED_ALLOCATE);
+	
+	soa.aperture = PI/3;
+	for (int k = 0; k < soa.num_nodes; k++) soa.apertures[k] = PI/8;
+	ik_soa_to_chain(&chain, &soa);
+	
+	if (fabs(chain.limit.cos_ap - cos(PI/3)) > worst) worst = fabs(chain.limit.cos_ap - cos(PI/3));
+	for (int k = 0; k < chain.num_nodes; k++)
+		if (fabs(chain.limits[k].cos_ap - cos(PI/8)) > worst) worst = fabs(chain.limits[k].cos_ap - cos(PI/8));
+	
+	__test_report("limits after ik_soa_to_chain", worst < 0.000001, "%g", worst);
+	
+	ik_soa_free(&soa);
+	free(chain.nodes);
+}
+
+int main() {
+	__test_solver(4, 0);
+	__test_solver(16, 0);
+	__test_solver(4, 1);
+	__test_solver(16, 1);
+	__test_limits();
+	
+	return __test_failed;
+}
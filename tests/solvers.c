@@ -0,0 +1,114 @@
+/* benchmark of the cost per converged solve of FABRIK, CCD, the jacobian
+ * transpose and damped least squares. every solver gets the same budget
+ * (`IK_FABRIK_DEFAULTS`), and solves scattered targets from the straight
+ * chain (cold) and then a moving target from the pose of the frame before
+ * (tracking). the cost per converged solve is the time of all solves over
+ * the number that got within the tolerance, so a solver that is cheap but
+ * gives up early does not look good.
+ *
+ *     make bench_solvers */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define BENCH_TARGETS 200
+#define BENCH_RUNS 3 // the best of these is reported
+#define BENCH_REACH 300 // length of every chain, split into equal bones
+
+enum {BENCH_FABRIK, BENCH_CCD, BENCH_JT, BENCH_DLS};
+static const char* __bench_solvers[] = {"fabrik", "ccd", "jt", "dls"};
+
+static struct ik_jacobian __bench_ws;
+
+/* where the effector of a chain of `_bones` bones ends up with every joint
+ * bent by up to 80% of its limit (so every target is reachable), the bends
+ * wander slowly with `_t` */
+static vec3f __bench_target(int _bones, real _t) {
+	real length = (real) BENCH_REACH / _bones;
+	vec3f pos = {0, 0, 0}, dir = {1, 0, 0};
+	
+	for (int k = 0; k < _bones; k++) {
+		real limit = k == 0 ? PI / 2 : PI / 6;
+		real bend = 0.8 * limit * sin(_t * 0.03 + k * 0.7);
+		real phi = _t * 0.02 + k * 1.3;
+		
+		vec3f axis = norm3f(cross3f(dir, (vec3f) {0, cos(phi), sin(phi)}));
+		dir = norm3f(qrot(make_qrot(axis, bend), dir));
+		pos = add3f(pos, mul3f(dir, length));
+	}
+	
+	return pos;
+}
+
+static void __bench_solve(struct ik_chain* _chain, int _solver, vec3f _target, struct ik_solve_result* _res) {
+	struct ik_solve_opts opts = IK_FABRIK_DEFAULTS;
+	struct ik_target target = {0, _target};
+	real damping = 0.1 * _chain->nodes[1].length;
+	
+	switch (_solver) {
+		case BENCH_FABRIK: ik_chain_solve_fabrik(_chain, _target, &opts, _res); break;
+		case BENCH_CCD: ik_chain_solve_ccd(_chain, _target, 1, &opts, _res); break;
+		case BENCH_JT: ik_chain_solve_jt(_chain, &__bench_ws, &target, 1, &opts, _res); break;
+		case BENCH_DLS: ik_chain_solve_dls(_chain, &__bench_ws, &target, 1, damping, &opts, _res); break;
+	}
+}
+
+int main(void) {
+	static const short bones[] = {4, 16, 64};
+	static const char* modes[] = {"cold", "tracking"};
+	vec3f targets[BENCH_TARGETS];
+	
+	if (ik_jacobian_alloc(&__bench_ws, 65, 1) == -1) XERR("failed to allocate the workspace!", ERROR_FAILED_ALLOCATE);
+	
+	printf("mode      bones  solver  converged  iterations  us/solve  us/converged\n");
+	
+	for (int tracking = 0; tracking < 2; tracking++) {
+		for (int b = 0; b < 3; b++) {
+			struct ik_chain chain;
+			if (ik_make_chain(&chain, bones[b], (real) BENCH_REACH / bones[b]) == -1)
+				XERR("failed to allocate the chain!", ERROR_FAILED_ALLOCATE);
+			
+			for (int i = 0; i < BENCH_TARGETS; i++) targets[i] = __bench_target(bones[b], tracking ? i : i * 37);
+			
+			for (int s = BENCH_FABRIK; s <= BENCH_DLS; s++) {
+				int converged = 0;
+				long iterations = 0;
+				double best = 1e30;
+				
+				for (int run = 0; run < BENCH_RUNS; run++) {
+					struct ik_solve_result res;
+					uint64_t ns = 0;
+					converged = 0;
+					iterations = 0;
+					
+					// resetting is not part of the cost
+					for (int i = 0; i < BENCH_TARGETS; i++) {
+						if (!tracking || i == 0) ik_reset_chain(&chain);
+						
+						uint64_t start = __tp_now_ns();
+						__bench_solve(&chain, s, targets[i], &res);
+						ns += __tp_now_ns() - start;
+						
+						if (res.error <= IK_FABRIK_DEFAULTS.tolerance) converged++;
+						iterations += res.iterations;
+					}
+					
+					if (ns < best) best = ns;
+				}
+				
+				printf(
+					"%-9s %-6d %-7s %4d/%-5d %-11.1f %-9.2f ",
+					modes[tracking], bones[b], __bench_solvers[s], converged, BENCH_TARGETS,
+					(double) iterations / BENCH_TARGETS, best / 1000 / BENCH_TARGETS
+				);
+				if (converged) printf("%.2f\n", best / 1000 / converged);
+				else printf("-\n");
+			}
+			
+			free(chain.nodes);
+		}
+	}
+	
+	ik_jacobian_free(&__bench_ws);
+	return 0;
+}
@@ -0,0 +1,100 @@
+/* benchmark of the batch solvers of inc/ik_batch.h against solving chains
+ * that were each allocated on their own, for growing numbers of 16 bone
+ * chains tracking targets that move a little every frame. reports the
+ * microseconds per frame of every solver (the best of BENCH_RUNS runs of
+ * BENCH_FRAMES frames), the threaded ones on a pool with a worker per cpu.
+ *
+ *     make bench_batch */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define BENCH_BONES 16
+#define BENCH_LENGTH 10
+#define BENCH_FRAMES 20
+#define BENCH_RUNS 3 // the best of these is reported
+#define BENCH_MAX_CHAINS 4096
+
+enum {BENCH_SEPARATE, BENCH_FABRIK, BENCH_SIMD, BENCH_FABRIK_MT, BENCH_CCD, BENCH_CCD_MT, BENCH_SOLVERS};
+static const char* __bench_solvers[] = {"separate", "fabrik", "simd", "fabrik mt", "ccd", "ccd mt"};
+
+static struct tp_pool __bench_pool;
+static struct ik_chain __bench_chains[BENCH_MAX_CHAINS];
+static vec3f __bench_targets[BENCH_MAX_CHAINS];
+
+/* target of chain `_i` in frame `_frame`, around 60% of its reach */
+static vec3f __bench_target(int _i, int _frame) {
+	real t = _i * 0.37 + _frame * 0.05;
+	return (vec3f) {90 + 20 * cos(t), 30 * sin(t), 20 * sin(0.6 * t)};
+}
+
+static void __bench_frame(int _solver, struct ik_batch* _batch, int _num_chains) {
+	switch (_solver) {
+		case BENCH_SEPARATE:
+			for (int i = 0; i < _num_chains; i++) ik_chain_solve_fabrik(&__bench_chains[i], __bench_targets[i], 0, 0);
+			break;
+		case BENCH_FABRIK: ik_batch_solve_fabrik(_batch, __bench_targets, 0); break;
+		case BENCH_SIMD: ik_batch_solve_fabrik_simd(_batch, __bench_targets, 0); break;
+		case BENCH_FABRIK_MT: ik_batch_solve_fabrik_mt(_batch, __bench_targets, 0, &__bench_pool); break;
+		case BENCH_CCD: ik_batch_solve_ccd(_batch, __bench_targets, 1, 0); break;
+		case BENCH_CCD_MT: ik_batch_solve_ccd_mt(_batch, __bench_targets, 1, 0, &__bench_pool); break;
+	}
+}
+
+/* microseconds per frame of `_solver` on `_num_chains` chains */
+static double __bench_run(int _solver, int _num_chains) {
+	struct ik_batch batch;
+	double best = 1e30;
+	
+	if (ik_batch_init(&batch, _num_chains, _num_chains * (BENCH_BONES + 1)) == -1)
+		XERR("failed to allocate the batch!", ERROR_FAILED_ALLOCATE);
+	
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		uint64_t ns = 0;
+		
+		// every run starts from the straight chains
+		ik_batch_clear(&batch);
+		for (int i = 0; i < _num_chains; i++) {
+			ik_reset_chain(&__bench_chains[i]);
+			ik_batch_add_chain(&batch, &__bench_chains[i]);
+		}
+		
+		for (int f = 0; f < BENCH_FRAMES; f++) {
+			for (int i = 0; i < _num_chains; i++) __bench_targets[i] = __bench_target(i, f);
+			
+			uint64_t start = __tp_now_ns();
+			__bench_frame(_solver, &batch, _num_chains);
+			ns += __tp_now_ns() - start;
+		}
+		
+		if (ns < best) best = ns;
+	}
+	
+	ik_batch_free(&batch);
+	return best / 1000 / BENCH_FRAMES;
+}
+
+int main(void) {
+	static const int counts[] = {16, 64, 256, 1024, BENCH_MAX_CHAINS};
+	
+	if (tp_init(&__bench_pool, 0, IK_BATCH_MAX_JOBS) == -1) XERR("failed to start the thread pool!", ERROR_FAILED_ALLOCATE);
+	
+	for (int i = 0; i < BENCH_MAX_CHAINS; i++)
+		if (ik_make_chain(&__bench_chains[i], BENCH_BONES, BENCH_LENGTH) == -1)
+			XERR("failed to allocate the chains!", ERROR_FAILED_ALLOCATE);
+	
+	printf("%d workers, %d lanes, us per frame\n", __bench_pool.num_workers, ik_simd_width());
+	printf("chains ");
+	for (int s = 0; s < BENCH_SOLVERS; s++) printf(" %10s", __bench_solvers[s]);
+	printf("\n");
+	
+	for (int c = 0; c < (int) (sizeof(counts) / sizeof(counts[0])); c++) {
+		printf("%-6d ", counts[c]);
+		for (int s = 0; s < BENCH_SOLVERS; s++) printf(" %10.1f", __bench_run(s, counts[c]));
+		printf("\n");
+	}
+	
+	for (int i = 0; i < BENCH_MAX_CHAINS; i++) free(__bench_chains[i].nodes);
+	tp_destroy(&__bench_pool);
+	return 0;
+}
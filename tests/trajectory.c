@@ -0,0 +1,115 @@
+/* tests of the offline trajectory solvers (see inc/ik_trajectory.h). a
+ * trajectory streamed into a file through a window of a few frames has to
+ * hold the same bytes as one solved into memory, and trajectories solved on
+ * a thread pool have to match solving them one after the other. returns
+ * non-zero if a check fails.
+ *
+ *     make test_trajectory */
+
+#define IK_TRAJECTORY_WINDOW 4096 // a few frames, so that the file takes many windows
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define TRAJECTORY_FRAMES 300
+#define TRAJECTORY_CHAINS 6
+#define TRAJECTORY_PATH "/tmp/ik_test_trajectory"
+
+static int __test_failed = 0;
+
+static void __test_report(const char* _name, int _ok, const char* _fmt, double _value) {
+	printf("%s %s: ", _ok ? "ok  " : "FAIL", _name);
+	printf(_fmt, _value);
+	printf("\n");
+	if (!_ok) __test_failed = 1;
+}
+
+/* a target moving along a knot around the root of chain `_c` */
+static void __test_targets(vec3f* _targets, int _c, real _reach) {
+	for (int f = 0; f < TRAJECTORY_FRAMES; f++) {
+		real a = 0.05 * f + _c;
+		_targets[f] = mul3f((vec3f) {cos(a) + 0.3 * cos(3 * a), sin(a) - 0.3 * sin(3 * a), 0.4 * sin(2 * a)}, 0.6 * _reach);
+	}
+}
+
+static void __test_file(void) {
+	struct ik_chain chain;
+	vec3f targets[TRAJECTORY_FRAMES];
+	int bones = 13; // 14 nodes, frames straddle the window and page boundaries
+	size_t frame_size = (bones + 1) * sizeof(struct ik_node_pose);
+	struct ik_node_pose* poses = malloc(TRAJECTORY_FRAMES * frame_size);
+	char* file = malloc(sizeof(struct ik_trajectory_header) + TRAJECTORY_FRAMES * frame_size + 1);
+	if (!poses || !file || ik_make_chain(&chain, bones, 20) == -1) XERR("failed to allocate memory!", ERROR_FAILED_ALLOCATE);
+	
+	__test_targets(targets, 0, 20 * bones);
+	
+	int ret = ik_chain_solve_trajectory(&chain, targets, TRAJECTORY_FRAMES, poses, 0, 0);
+	ik_reset_chain(&chain);
+	ik_chain_invalidate(&chain);
+	ret |= ik_chain_solve_trajectory_file(&chain, targets, TRAJECTORY_FRAMES, TRAJECTORY_PATH, 0);
+	
+	FILE* in = fopen(TRAJECTORY_PATH, "rb");
+	size_t size = in ? fread(file, 1, sizeof(struct ik_trajectory_header) + TRAJECTORY_FRAMES * frame_size + 1, in) : 0;
+	if (in) fclose(in);
+	
+	struct ik_trajectory_header* h = (struct ik_trajectory_header*) file;
+	int header_ok = size >= sizeof(*h) && !memcmp(h->magic, IK_TRAJECTORY_MAGIC, 4) &&
+		h->real_size == sizeof(real) && h->num_nodes == bones + 1 && h->num_frames == TRAJECTORY_FRAMES;
+	
+	__test_report("file written", ret == 0 && header_ok, "%g windows", (double) TRAJECTORY_FRAMES * frame_size / IK_TRAJECTORY_WINDOW);
+	__test_report("file size", size == sizeof(*h) + TRAJECTORY_FRAMES * frame_size, "%g bytes", size);
+	__test_report("file matches memory", size == sizeof(*h) + TRAJECTORY_FRAMES * frame_size &&
+		!memcmp(file + sizeof(*h), poses, TRAJECTORY_FRAMES * frame_size), "%g frames", TRAJECTORY_FRAMES);
+	
+	unlink(TRAJECTORY_PATH);
+	free(chain.nodes);
+	free(poses);
+	free(file);
+}
+
+static void __test_threaded(void) {
+	struct ik_chain serial[TRAJECTORY_CHAINS], threaded[TRAJECTORY_CHAINS];
+	struct ik_trajectory_job jobs[TRAJECTORY_CHAINS];
+	struct ik_node_pose* poses[2][TRAJECTORY_CHAINS];
+	vec3f targets[TRAJECTORY_CHAINS][TRAJECTORY_FRAMES];
+	struct tp_pool pool;
+	int same = 1;
+	
+	if (tp_init(&pool, 4, TRAJECTORY_CHAINS) == -1) XERR("failed to start the thread pool!", ERROR_FAILED_ALLOCATE);
+	
+	for (int c = 0; c < TRAJECTORY_CHAINS; c++) {
+		int bones = 3 + 5 * c;
+		if (
+			ik_make_chain(&serial[c], bones, 10) == -1 || ik_make_chain(&threaded[c], bones, 10) == -1 ||
+			!(poses[0][c] = malloc(TRAJECTORY_FRAMES * (bones + 1) * sizeof(struct ik_node_pose))) ||
+			!(poses[1][c] = malloc(TRAJECTORY_FRAMES * (bones + 1) * sizeof(struct ik_node_pose)))
+		) XERR("failed to allocate memory!", ERROR_FAILED_ALLOCATE);
+		
+		__test_targets(targets[c], c, 10 * bones);
+		jobs[c] = (struct ik_trajectory_job) {&threaded[c], targets[c], TRAJECTORY_FRAMES, poses[1][c], 0, 0};
+	}
+	
+	int ret = 0;
+	for (int c = 0; c < TRAJECTORY_CHAINS; c++)
+		ret |= ik_chain_solve_trajectory(&serial[c], targets[c], TRAJECTORY_FRAMES, poses[0][c], 0, 0);
+	ret |= ik_solve_trajectories_mt(jobs, TRAJECTORY_CHAINS, &pool);
+	
+	for (int c = 0; c < TRAJECTORY_CHAINS; c++)
+		if (memcmp(poses[0][c], poses[1][c], TRAJECTORY_FRAMES * serial[c].num_nodes * sizeof(struct ik_node_pose))) same = 0;
+	
+	__test_report("threaded matches serial", ret == 0 && same, "%g chains", TRAJECTORY_CHAINS);
+	
+	tp_destroy(&pool);
+	for (int c = 0; c < TRAJECTORY_CHAINS; c++) {
+		free(serial[c].nodes);
+		free(threaded[c].nodes);
+		free(poses[0][c]);
+		free(poses[1][c]);
+	}
+}
+
+int main() {
+	__test_file();
+	__test_threaded();
+	
+	return __test_failed;
+}
@@ -0,0 +1,132 @@
+/* tests of the skeleton tree solver (see inc/ik_tree.h). returns non-zero
+ * if a solve misses its target, or if the threaded solver's pose differs
+ * from the serial one in any bit.
+ *
+ *     make test_tree */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define TREE_FRAMES 50
+
+static int __test_failed = 0;
+
+/* a straight line of `_count` bones of length 100 along x */
+static void __test_line(struct ik_tree* _tree, int _count) {
+	if (ik_tree_alloc(_tree, _count + 1) == -1) XERR("failed to allocate the tree!", ERROR_FAILED_ALLOCATE);
+	
+	ik_tree_add(_tree, -1, (vec3f) {0, 0, 0}, 1.5);
+	for (int i = 1; i <= _count; i++)
+		ik_tree_add(_tree, i - 1, (vec3f) {100 * i, 0, 0}, 1.5);
+}
+
+static void __test_solve(const char* _name, struct ik_tree* _tree, struct ik_target* _targets, int _num_targets, real _bound) {
+	struct ik_solve_result res;
+	
+	if (ik_tree_solve_fabrik(_tree, _targets, _num_targets, 0, &res) == -1 || res.error > _bound) {
+		printf("FAIL %s: error %g after %d iterations\n", _name, (double) res.error, res.iterations);
+		__test_failed = 1;
+	} else {
+		printf("ok   %s: error %g after %d iterations\n", _name, (double) res.error, res.iterations);
+	}
+	
+	// bones keep their lengths
+	for (int i = 1; i < _tree->num_nodes; i++) {
+		struct ik_tree_node* n = &_tree->nodes[i];
+		real length = mag3f(sub3f(n->pos, _tree->nodes[n->parent].pos));
+		if (fabs(length - n->length) > 0.001) {
+			printf("FAIL %s: bone %d has length %g instead of %g\n", _name, i, (double) length, (double) n->length);
+			__test_failed = 1;
+		}
+	}
+}
+
+/* adds `_count` bones of length 30 below `_parent` along `_dir`, and returns
+ * the last node */
+static short __test_limb(struct ik_tree* _tree, short _parent, vec3f _dir, int _count) {
+	for (int i = 0; i < _count; i++)
+		_parent = ik_tree_add(_tree, _parent, add3f(_tree->nodes[_parent].pos, mul3f(_dir, 30)), 1);
+	return _parent;
+}
+
+/* a character: a spine from the pelvis (the root) to the chest, two arms and
+ * a head on the chest and a leg on the pelvis, its hands, head and foot
+ * pulled along circles. the threaded solve has to give the serial one's
+ * pose bit for bit, every frame. */
+static void __test_threaded(void) {
+	struct ik_tree serial, threaded;
+	struct tp_pool pool;
+	short effectors[4];
+	int identical = 1;
+	
+	for (int t = 0; t < 2; t++) {
+		struct ik_tree* tree = t ? &threaded : &serial;
+		if (ik_tree_alloc(tree, 32) == -1) XERR("failed to allocate the tree!", ERROR_FAILED_ALLOCATE);
+		
+		ik_tree_add(tree, -1, (vec3f) {0, 0, 0}, 1);
+		short chest = __test_limb(tree, 0, (vec3f) {0, 1, 0}, 4);
+		effectors[0] = __test_limb(tree, chest, (vec3f) {-1, 0, 0}, 5);
+		effectors[1] = __test_limb(tree, chest, (vec3f) {1, 0, 0}, 5);
+		effectors[2] = __test_limb(tree, chest, (vec3f) {0, 1, 0}, 2);
+		effectors[3] = __test_limb(tree, 0, (vec3f) {0, -1, 0}, 6);
+	}
+	
+	if (tp_init(&pool, 4, 32) == -1) XERR("failed to start the thread pool!", ERROR_FAILED_ALLOCATE);
+	
+	for (int f = 0; f < TREE_FRAMES && identical; f++) {
+		real a = 0.2 * f;
+		struct ik_target targets[4];
+		for (int e = 0; e < 4; e++) {
+			vec3f rest = serial.nodes[effectors[e]].pos;
+			targets[e] = (struct ik_target) {effectors[e], add3f(rest, (vec3f) {40 * cos(a + e), 40 * sin(a + e), 20 * sin(2 * a)})};
+		}
+		
+		struct ik_solve_result res_serial, res_threaded;
+		ik_tree_solve_fabrik(&serial, targets, 4, 0, &res_serial);
+		ik_tree_solve_fabrik_mt(&threaded, targets, 4, 0, &res_threaded, &pool);
+		
+		if (res_serial.iterations != res_threaded.iterations || res_serial.error != res_threaded.error) identical = 0;
+		for (int i = 0; i < serial.num_nodes; i++)
+			if (memcmp(&serial.nodes[i].pos, &threaded.nodes[i].pos, sizeof(vec3f)) ||
+				memcmp(&serial.nodes[i].rtn, &threaded.nodes[i].rtn, sizeof(vec3f))) identical = 0;
+	}
+	
+	printf("%s threaded rig: %s\n", identical ? "ok  " : "FAIL", identical ? "same pose as serial" : "pose differs from serial");
+	if (!identical) __test_failed = 1;
+	
+	tp_destroy(&pool);
+	ik_tree_free(&serial);
+	ik_tree_free(&threaded);
+}
+
+int main(void) {
+	struct ik_tree tree;
+	
+	// a target on the leaf
+	__test_line(&tree, 3);
+	__test_solve("leaf target", &tree, (struct ik_target[]) {{3, {150, 80, 0}}}, 1, 0.01);
+	ik_tree_free(&tree);
+	
+	// a target halfway down the line, the bone below it must not be pulled
+	// towards the origin
+	__test_line(&tree, 3);
+	__test_solve("mid-segment target", &tree, (struct ik_target[]) {{2, {150, 80, 0}}}, 1, 0.01);
+	ik_tree_free(&tree);
+	
+	// a target on a sub-base whose branches have none
+	if (ik_tree_alloc(&tree, 6) == -1) XERR("failed to allocate the tree!", ERROR_FAILED_ALLOCATE);
+	ik_tree_add(&tree, -1, (vec3f) {0, 0, 0}, 1.5);
+	ik_tree_add(&tree, 0, (vec3f) {0, 100, 0}, 1.5);
+	ik_tree_add(&tree, 1, (vec3f) {0, 200, 0}, 1.5);
+	ik_tree_add(&tree, 2, (vec3f) {-100, 250, 0}, 1.5);
+	ik_tree_add(&tree, 2, (vec3f) {100, 250, 0}, 1.5);
+	__test_solve("sub-base target", &tree, (struct ik_target[]) {{2, {80, 150, 0}}}, 1, 0.01);
+	
+	// both hands
+	__test_solve("two effectors", &tree, (struct ik_target[]) {{3, {-90, 250, 30}}, {4, {90, 250, 30}}}, 2, 0.01);
+	ik_tree_free(&tree);
+	
+	__test_threaded();
+	
+	return __test_failed;
+}
@@ -0,0 +1,138 @@
+/* checks the batched helpers of inc/linalg_simd.h against their `_ref`
+ * versions, for every count up to VEC_MAX so that the vector bodies and
+ * their scalar tails are both covered, out of place and in place. on
+ * machines without AVX2 both sides are the reference and agree exactly.
+ * returns non-zero if a difference goes past the bound (a few units of
+ * rounding, `RSQRT`'s error for the normalising ones).
+ *
+ *     make test_vec */
+
+#define IK_NO_MAIN
+#include "../skeleton.c"
+
+#define VEC_MAX 37
+#define VEC_EPS (sizeof(real) == 4 ? 1.2e-7 : 2.2e-16)
+#define VEC_BOUND (16 * VEC_EPS) // relative to the magnitude of the inputs
+#define VEC_NORM_BOUND (LINALG_MATH_TIER == LINALG_FASTEST ? 4e-3 : 1e-5)
+#define VEC_MATRICES 1000
+
+static int __test_failed = 0;
+static unsigned __test_seed = 1;
+
+static real __test_rand(void) {
+	__test_seed = __test_seed * 1103515245 + 12345;
+	return (real) ((__test_seed >> 8) & 0xFFFF) / 0xFFFF;
+}
+
+static void __test_report(const char* _name, int _ok, const char* _fmt, double _value) {
+	printf("%s %s: ", _ok ? "ok  " : "FAIL", _name);
+	printf(_fmt, _value);
+	printf("\n");
+	if (!_ok) __test_failed = 1;
+}
+
+static vec3f __test_vec(void) {
+	return (vec3f) {200 * __test_rand() - 100, 200 * __test_rand() - 100, 200 * __test_rand() - 100};
+}
+
+/* the larger of two errors, a NaN counting as an infinite one */
+static double __test_worse(double _worst, double _d) {
+	return _d <= _worst ? _worst : isnan(_d) ? INFINITY : _d;
+}
+
+/* largest difference between two arrays of vectors, relative to `_scale` */
+static double __test_diff(vec3f* _a, vec3f* _b, int _n, double _scale) {
+	double worst = 0;
+	for (int i = 0; i < _n; i++) worst = __test_worse(worst, mag3f(sub3f(_a[i], _b[i])) / _scale);
+	return worst;
+}
+
+static void __test_arrays(void) {
+	vec3f a[VEC_MAX], b[VEC_MAX], out[VEC_MAX], ref[VEC_MAX];
+	real x[VEC_MAX], y[VEC_MAX], z[VEC_MAX], dots[VEC_MAX], dots_ref[VEC_MAX];
+	double err_qrot = 0, err_norm = 0, err_dot = 0, err_cross = 0, err_qrot_soa = 0, err_norm_soa = 0;
+	
+	for (int n = 0; n <= VEC_MAX; n++) {
+		for (int i = 0; i < n; i++) a[i] = __test_vec(), b[i] = __test_vec();
+		qtrn q = make_qrot(norm3f(__test_vec()), 6 * __test_rand() - 3);
+		
+		qrot_n(q, out, a, n);
+		qrot_n_ref(q, ref, a, n);
+		err_qrot = __test_worse(err_qrot, __test_diff(out, ref, n, 100));
+		memcpy(out, a, n * sizeof(vec3f));
+		qrot_n(q, out, out, n);
+		err_qrot = __test_worse(err_qrot, __test_diff(out, ref, n, 100));
+		
+		norm3f_n(out, a, n);
+		norm3f_n_ref(ref, a, n);
+		err_norm = __test_worse(err_norm, __test_diff(out, ref, n, 1));
+		memcpy(out, a, n * sizeof(vec3f));
+		norm3f_n(out, out, n);
+		err_norm = __test_worse(err_norm, __test_diff(out, ref, n, 1));
+		
+		dot3f_n(dots, a, b, n);
+		dot3f_n_ref(dots_ref, a, b, n);
+		for (int i = 0; i < n; i++) err_dot = __test_worse(err_dot, fabs(dots[i] - dots_ref[i]) / (100 * 100));
+		
+		cross3f_n(out, a, b, n);
+		cross3f_n_ref(ref, a, b, n);
+		err_cross = __test_worse(err_cross, __test_diff(out, ref, n, 100 * 100));
+		
+		// the soa versions work in place
+		for (int i = 0; i < n; i++) x[i] = a[i].x, y[i] = a[i].y, z[i] = a[i].z;
+		qrot_soa(q, x, y, z, n);
+		for (int i = 0; i < n; i++) out[i] = (vec3f) {x[i], y[i], z[i]};
+		qrot_n_ref(q, ref, a, n);
+		err_qrot_soa = __test_worse(err_qrot_soa, __test_diff(out, ref, n, 100));
+		
+		for (int i = 0; i < n; i++) x[i] = a[i].x, y[i] = a[i].y, z[i] = a[i].z;
+		norm3f_soa(x, y, z, n);
+		for (int i = 0; i < n; i++) out[i] = (vec3f) {x[i], y[i], z[i]};
+		norm3f_n_ref(ref, a, n);
+		err_norm_soa = __test_worse(err_norm_soa, __test_diff(out, ref, n, 1));
+	}
+	
+	__test_report("qrot_n", err_qrot <= VEC_BOUND, "%g", err_qrot);
+	__test_report("norm3f_n", err_norm <= VEC_NORM_BOUND, "%g", err_norm);
+	__test_report("dot3f_n", err_dot <= VEC_BOUND, "%g", err_dot);
+	__test_report("cross3f_n", err_cross <= VEC_BOUND, "%g", err_cross);
+	__test_report("qrot_soa", err_qrot_soa <= VEC_BOUND, "%g", err_qrot_soa);
+	__test_report("norm3f_soa", err_norm_soa <= VEC_NORM_BOUND, "%g", err_norm_soa);
+}
+
+static void __test_matrices(void) {
+	double err_mmul = 0, err_vec = 0;
+	
+	for (int m = 0; m < VEC_MATRICES; m++) {
+		mat4f a, b, r, ref;
+		for (int i = 0; i < 16; i++) a.get[i] = 20 * __test_rand() - 10, b.get[i] = 20 * __test_rand() - 10;
+		vec4f v = {20 * __test_rand() - 10, 20 * __test_rand() - 10, 20 * __test_rand() - 10, 20 * __test_rand() - 10};
+		
+		mmul4f(&r, &a, &b);
+		mmul4f_ref(&ref, &a, &b);
+		for (int i = 0; i < 16; i++) err_mmul = __test_worse(err_mmul, fabs(r.get[i] - ref.get[i]) / (10 * 10));
+		
+		// the result may be either operand
+		r = a;
+		mmul4f(&r, &r, &b);
+		for (int i = 0; i < 16; i++) err_mmul = __test_worse(err_mmul, fabs(r.get[i] - ref.get[i]) / (10 * 10));
+		r = b;
+		mmul4f(&r, &a, &r);
+		for (int i = 0; i < 16; i++) err_mmul = __test_worse(err_mmul, fabs(r.get[i] - ref.get[i]) / (10 * 10));
+		
+		vec4f w = mmul_vec4f(&a, v), w_ref = mmul_vec4f_ref(&a, v);
+		vec4f d = {fabs(w.x - w_ref.x), fabs(w.y - w_ref.y), fabs(w.z - w_ref.z), fabs(w.w - w_ref.w)};
+		err_vec = __test_worse(err_vec, (d.x + d.y + d.z + d.w) / (10 * 10));
+	}
+	
+	__test_report("mmul4f", err_mmul <= VEC_BOUND, "%g", err_mmul);
+	__test_report("mmul_vec4f", err_vec <= VEC_BOUND, "%g", err_vec);
+}
+
+int main() {
+	printf("%s build, avx2 %s\n", sizeof(real) == 4 ? "float" : "double", linalg_has_avx2() ? "on" : "off");
+	__test_arrays();
+	__test_matrices();
+	
+	return __test_failed;
+}